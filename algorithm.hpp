@@ -1,7 +1,14 @@
 #ifndef SJTU_ALGORITHM_HPP
 #define SJTU_ALGORITHM_HPP
 
+#include <cstddef>
+#include <cstring>
 #include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "simd_sort.hpp"
 
 namespace sjtu{
 
@@ -23,26 +30,493 @@ void sort(T *begin, T *end, std::function<bool(const T&, const T&)> cmp){
     if (end - i > 1) sort(i, end, cmp);
 }
 
+/**
+ * sort by operator<. int32 / int64 / float / double ranges go to the
+ * vector kernel of simd_sort.hpp when the CPU has one; its result is the
+ * same as the comparator version's.
+ */
+template<typename T>
+void sort(T *begin, T *end){
+    if (simd::sort(begin, end)) return;
+    sort<T>(begin, end, [](const T &a, const T &b){ return a < b; });
+}
+
+/**
+ * binary searches over [begin, end), which must be sorted by cmp.
+ * Branchless: every step halves the range with a conditional add instead
+ * of a jump, so the loop runs exactly ceil(log2 n) times and never
+ * mispredicts; the two possible next midpoints are prefetched one step
+ * ahead. Only cmp (default operator<) is used and sizes are size_t.
+ */
+template<class T, class Compare>
+T *lower_bound(const T *begin, const T *end, const T &num, Compare cmp){
+    size_t len = end - begin;
+    if (len == 0) return const_cast<T *>(begin);
+    const T *base = begin;
+    while (len > 1){
+        size_t half = len / 2;
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+        base += static_cast<size_t>(cmp(base[half], num)) * half;
+        len -= half;
+    }
+    return const_cast<T *>(base + static_cast<size_t>(cmp(*base, num)));
+}
+
+template<class T, class Compare>
+T *upper_bound(const T *begin, const T *end, const T &num, Compare cmp){
+    size_t len = end - begin;
+    if (len == 0) return const_cast<T *>(begin);
+    const T *base = begin;
+    while (len > 1){
+        size_t half = len / 2;
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+        base += static_cast<size_t>(!cmp(num, base[half])) * half;
+        len -= half;
+    }
+    return const_cast<T *>(base + static_cast<size_t>(!cmp(num, *base)));
+}
+
 template<class T>
 T *upper_bound(const T *begin, const T *end, const T &num){
-    int l = -1, r = end - begin;
-    while (l + 1 < r){
-        int mid = (l + r) >> 1;
-        if (num < *(begin + mid)) r = mid; else l = mid;
-    }
-    return const_cast<T *>(begin + r);
+    return upper_bound(begin, end, num, std::less<T>());
 }
 
 template<class T>
 T *lower_bound(const T *begin, const T *end, const T &num){
-    int l = -1, r = end - begin;
-    while (l + 1 < r){
-        int mid = (l + r) >> 1;
-        if (num <= *(begin + mid)) r = mid; else l = mid;
+    return lower_bound(begin, end, num, std::less<T>());
+}
+
+/**
+ * lower_bound for a batch of queries: out[i] = lower_bound(begin, end, query[i]).
+ * Meant for ascending queries: each search gallops forward from the
+ * previous answer, so a dense sorted batch costs O(log gap) per query
+ * instead of O(log n). A query smaller than its predecessor restarts from
+ * begin, so unsorted batches are still answered correctly.
+ */
+template<class T, class Compare>
+void lower_bound_many(const T *begin, const T *end, const T *queryBegin, const T *queryEnd, T **out, Compare cmp){
+    const T *from = begin;
+    for (const T *q = queryBegin; q != queryEnd; ++q, ++out){
+        if (q != queryBegin && cmp(*q, *(q - 1))) from = begin;
+        size_t step = 1;
+        const T *to = from;
+        while (to < end && cmp(*to, *q)){
+            from = to + 1;
+            to = static_cast<size_t>(end - to) > step ? to + step : end;
+            step *= 2;
+        }
+        from = lower_bound(from, to, *q, cmp);
+        *out = const_cast<T *>(from);
     }
-    return const_cast<T *>(begin + r);
 }
 
+template<class T>
+void lower_bound_many(const T *begin, const T *end, const T *queryBegin, const T *queryEnd, T **out){
+    lower_bound_many(begin, end, queryBegin, queryEnd, out, std::less<T>());
+}
+
+/**
+ * merge the sorted ranges [first1, last1) and [first2, last2) into out,
+ * which must hold enough constructed elements; equal elements keep their
+ * order, those of the first range first. Returns the end of the output.
+ */
+template<class T, class Compare>
+T *merge(const T *first1, const T *last1, const T *first2, const T *last2, T *out, Compare cmp){
+    while (first1 != last1 && first2 != last2){
+        if (cmp(*first2, *first1)) *out++ = *first2++;
+        else *out++ = *first1++;
+    }
+    while (first1 != last1) *out++ = *first1++;
+    while (first2 != last2) *out++ = *first2++;
+    return out;
+}
+
+template<class T>
+T *merge(const T *first1, const T *last1, const T *first2, const T *last2, T *out){
+    return merge(first1, last1, first2, last2, out, std::less<T>());
+}
+
+namespace detail{
+
+/**
+ * scratch space of up to `want` elements, copy-constructed from seed so
+ * that T needs no default constructor; empty if memory is short.
+ */
+template<class T>
+class merge_buffer{
+private:
+    T *data;
+    size_t count;
+
+public:
+    merge_buffer(const T *seed, size_t want) : data(nullptr), count(0){
+        if (want == 0) return;
+        data = static_cast<T *>(::operator new(sizeof(T) * want, std::nothrow));
+        if (data == nullptr) return;
+        try{
+            for (; count < want; ++count) new (data + count) T(seed[count]);
+        } catch (...){
+            while (count > 0) data[--count].~T();
+            ::operator delete(data);
+            throw;
+        }
+    }
+
+    ~merge_buffer(){
+        for (size_t i = 0; i < count; ++i) data[i].~T();
+        ::operator delete(data);
+    }
+
+    merge_buffer(const merge_buffer &) = delete;
+    merge_buffer &operator=(const merge_buffer &) = delete;
+
+    T *get() const{
+        return data;
+    }
+
+    size_t size() const{
+        return count;
+    }
+};
+
+template<class T>
+void reverse(T *begin, T *end){
+    while (begin < end) std::swap(*begin++, *--end);
+}
+
+/**
+ * rotate [begin, end) so that middle comes first; returns the new
+ * position of *begin.
+ */
+template<class T>
+T *rotate(T *begin, T *middle, T *end){
+    if (begin == middle) return end;
+    if (middle == end) return begin;
+    reverse(begin, middle);
+    reverse(middle, end);
+    reverse(begin, end);
+    return begin + (end - middle);
+}
+
+/**
+ * binary insertion sort: few comparisons, which is what matters when they
+ * go through pointers; inserting after equal elements keeps it stable.
+ */
+template<class T, class Compare>
+void insertionSort(T *begin, T *end, Compare cmp){
+    for (T *i = begin + 1; i < end; ++i){
+        if (!cmp(*i, *(i - 1))) continue;
+        T *pos = upper_bound(begin, i, *i, cmp);
+        T value = std::move(*i);
+        for (T *j = i; j != pos; --j) *j = std::move(*(j - 1));
+        *pos = std::move(value);
+    }
+}
+
+/**
+ * merge sorted [begin, middle) and [middle, end) in place using buf when
+ * the shorter side fits, otherwise split both sides around a pivot, rotate
+ * the inner parts into place and recurse (std::inplace_merge's scheme;
+ * O(n log n) moves when buf is empty).
+ */
+template<class T, class Compare>
+void mergeAdaptive(T *begin, T *middle, T *end, T *buf, size_t bufSize, Compare cmp){
+    if (begin == middle || middle == end || !cmp(*middle, *(middle - 1))) return;
+    // elements already in place at either end take no part in the merge
+    begin = upper_bound(begin, middle, *middle, cmp);
+    end = lower_bound(middle, end, *(middle - 1), cmp);
+    size_t len1 = middle - begin, len2 = end - middle;
+    if (len1 <= len2 && len1 <= bufSize){
+        T *bufEnd = buf;
+        for (T *p = begin; p != middle; ++p) *bufEnd++ = std::move(*p);
+        T *i = buf, *j = middle, *out = begin;
+        while (i != bufEnd && j != end){
+            if (cmp(*j, *i)) *out++ = std::move(*j++);
+            else *out++ = std::move(*i++);
+        }
+        while (i != bufEnd) *out++ = std::move(*i++);
+    } else if (len2 <= bufSize){
+        T *bufEnd = buf;
+        for (T *p = middle; p != end; ++p) *bufEnd++ = std::move(*p);
+        T *i = middle, *j = bufEnd, *out = end;
+        while (i != begin && j != buf){
+            if (cmp(*(j - 1), *(i - 1))) *--out = std::move(*--i);
+            else *--out = std::move(*--j);
+        }
+        while (j != buf) *--out = std::move(*--j);
+    } else if (len1 + len2 == 2){
+        std::swap(*begin, *middle);
+    } else{
+        T *cut1, *cut2;
+        if (len1 > len2){
+            cut1 = begin + len1 / 2;
+            cut2 = lower_bound(middle, end, *cut1, cmp);
+        } else{
+            cut2 = middle + len2 / 2;
+            cut1 = upper_bound(begin, middle, *cut2, cmp);
+        }
+        T *newMiddle = rotate(cut1, middle, cut2);
+        mergeAdaptive(begin, cut1, newMiddle, buf, bufSize, cmp);
+        mergeAdaptive(newMiddle, cut2, end, buf, bufSize, cmp);
+    }
+}
+
+const size_t INSERTION_SORT_LIMIT = 16;
+
+/**
+ * branch-free compare-exchange: min / max compile to cmov (or vector
+ * min / max), so sorting networks run without mispredictions.
+ */
+template<class T>
+inline void compareExchange(T &a, T &b){
+    T low = b < a ? b : a;
+    T high = b < a ? a : b;
+    a = low;
+    b = high;
+}
+
+/**
+ * optimal 8-input sorting network: 19 compare-exchanges in 6 layers.
+ */
+template<class T>
+inline void sortingNetwork8(T *a){
+    compareExchange(a[0], a[2]); compareExchange(a[1], a[3]); compareExchange(a[4], a[6]); compareExchange(a[5], a[7]);
+    compareExchange(a[0], a[4]); compareExchange(a[1], a[5]); compareExchange(a[2], a[6]); compareExchange(a[3], a[7]);
+    compareExchange(a[0], a[1]); compareExchange(a[2], a[3]); compareExchange(a[4], a[5]); compareExchange(a[6], a[7]);
+    compareExchange(a[2], a[4]); compareExchange(a[3], a[5]);
+    compareExchange(a[1], a[4]); compareExchange(a[3], a[6]);
+    compareExchange(a[1], a[2]); compareExchange(a[3], a[4]); compareExchange(a[5], a[6]);
+}
+
+/**
+ * sort integers: sorting networks on blocks of 8, then bottom-up
+ * branch-free merges ping-ponging with a buffer of n elements. Equal
+ * integers are indistinguishable, so the unstable network is harmless.
+ */
+template<class T>
+void sortIntegers(T *begin, T *end){
+    size_t len = end - begin;
+    size_t blocks = len / 8 * 8;
+    for (size_t i = 0; i < blocks; i += 8) sortingNetwork8(begin + i);
+    if (blocks < len) insertionSort(begin + blocks, end, std::less<T>());
+    if (len <= 8) return;
+    T *buf = static_cast<T *>(::operator new(sizeof(T) * len, std::nothrow));
+    if (buf == nullptr){
+        for (size_t width = 8; width < len; width *= 2){
+            for (size_t lo = 0; lo + width < len; lo += 2 * width){
+                size_t hi = lo + 2 * width < len ? lo + 2 * width : len;
+                mergeAdaptive(begin + lo, begin + lo + width, begin + hi, static_cast<T *>(nullptr), 0, std::less<T>());
+            }
+        }
+        return;
+    }
+    T *from = begin, *to = buf;
+    for (size_t width = 8; width < len; width *= 2){
+        for (size_t lo = 0; lo < len; lo += 2 * width){
+            size_t mid = lo + width < len ? lo + width : len;
+            size_t hi = lo + 2 * width < len ? lo + 2 * width : len;
+            const T *i = from + lo, *iEnd = from + mid, *j = from + mid, *jEnd = from + hi;
+            T *out = to + lo;
+            while (i != iEnd && j != jEnd){
+                bool takeRight = *j < *i;
+                *out++ = takeRight ? *j : *i;
+                j += takeRight;
+                i += !takeRight;
+            }
+            while (i != iEnd) *out++ = *i++;
+            while (j != jEnd) *out++ = *j++;
+        }
+        T *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != begin) memcpy(begin, from, sizeof(T) * len);
+    ::operator delete(buf);
+}
+
+template<class T, class Compare>
+void mergeSort(T *begin, T *end, T *buf, size_t bufSize, Compare cmp){
+    if (static_cast<size_t>(end - begin) <= INSERTION_SORT_LIMIT){
+        insertionSort(begin, end, cmp);
+        return;
+    }
+    T *middle = begin + (end - begin) / 2;
+    mergeSort(begin, middle, buf, bufSize, cmp);
+    mergeSort(middle, end, buf, bufSize, cmp);
+    mergeAdaptive(begin, middle, end, buf, bufSize, cmp);
+}
+
+}
+
+/**
+ * merge the sorted ranges [begin, middle) and [middle, end) in place,
+ * stably. Uses a temporary buffer as large as the shorter range if it can
+ * get one, and falls back to rotations (O(n log n)) otherwise.
+ */
+template<class T, class Compare>
+void inplace_merge(T *begin, T *middle, T *end, Compare cmp){
+    size_t len1 = middle - begin, len2 = end - middle;
+    if (len1 == 0 || len2 == 0 || !cmp(*middle, *(middle - 1))) return;
+    detail::merge_buffer<T> buf(begin, len1 < len2 ? len1 : len2);
+    detail::mergeAdaptive(begin, middle, end, buf.get(), buf.size(), cmp);
+}
+
+template<class T>
+void inplace_merge(T *begin, T *middle, T *end){
+    inplace_merge(begin, middle, end, std::less<T>());
+}
+
+/**
+ * stable merge sort: binary insertion sort on runs of up to 16 elements,
+ * then merges that skip already ordered halves and elements. With a
+ * buffer of n/2 elements it makes at most about n log2 n comparisons;
+ * without one (allocation failed) it merges by rotation in
+ * O(n log^2 n). Suited to the T* arrays list::sort() builds, where
+ * comparisons are the expensive part and moves are cheap.
+ */
+template<class T, class Compare>
+void stable_sort(T *begin, T *end, Compare cmp){
+    size_t len = end - begin;
+    if (len <= 1) return;
+    detail::merge_buffer<T> buf(begin, len <= detail::INSERTION_SORT_LIMIT ? 0 : len / 2);
+    detail::mergeSort(begin, end, buf.get(), buf.size(), cmp);
+}
+
+namespace detail{
+
+template<class T>
+void stableSortDefault(T *begin, T *end, std::true_type){
+    sortIntegers(begin, end);
+}
+
+template<class T>
+void stableSortDefault(T *begin, T *end, std::false_type){
+    stable_sort(begin, end, std::less<T>());
+}
+
+}
+
+/**
+ * stable_sort by operator<. Where stability cannot be observed, that is
+ * for integers, and for floating point without NaN or -0.0, this uses the
+ * vector kernel of simd_sort.hpp, or else for integers sorting networks and
+ * branch-free merges.
+ */
+template<class T>
+void stable_sort(T *begin, T *end){
+    if (simd::sort(begin, end)) return;
+    detail::stableSortDefault(begin, end, std::integral_constant<bool, std::is_integral<T>::value>());
+}
+
+/**
+ * a sorted array re-laid in Eytzinger (BFS heap) order: node k has children
+ * 2k and 2k+1. The first levels of the tree share a few cache lines and
+ * the descendants four levels down are contiguous, so one prefetch per
+ * step hides most of the memory latency when many queries hit an array
+ * much larger than the cache. Elements of more than 32 bytes fit less than
+ * two to a line, so they are searched without prefetching. Searches return pointers into the original
+ * array, which must outlive the index and stay unchanged.
+ */
+template<class T, class Compare = std::less<T>>
+class eytzinger_index{
+private:
+    const T *source;
+    size_t count;
+    T *tree;        // 1-based, tree[0] unused
+    size_t *rank;   // rank[k]: position of tree[k] in the source array
+    Compare cmp;
+
+    // at 1 the prefetch would name tree[k] itself, so it is left out
+    static const size_t PREFETCH_STRIDE = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+
+    void build(size_t k, size_t &next){
+        if (k > count) return;
+        build(2 * k, next);
+        new (tree + k) T(source[next]);
+        rank[k] = next++;
+        build(2 * k + 1, next);
+    }
+
+    /**
+     * destroy the first `built` nodes in the order build() made them
+     */
+    void destroy(size_t k, size_t &built){
+        if (k > count || built == 0) return;
+        destroy(2 * k, built);
+        if (built == 0) return;
+        tree[k].~T();
+        --built;
+        destroy(2 * k + 1, built);
+    }
+
+    /**
+     * descend while the node is smaller (less: cmp(node, num)) or not
+     * greater (!less: !cmp(num, node)) than num, then undo the trailing
+     * right turns to reach the answer.
+     */
+    template<bool Lower>
+    T *search(const T &num) const{
+        size_t k = 1;
+        while (k <= count){
+            if (PREFETCH_STRIDE > 1){
+                size_t ahead = k * PREFETCH_STRIDE;
+                __builtin_prefetch(tree + (ahead <= count ? ahead : 0));
+            }
+            bool right = Lower ? cmp(tree[k], num) : !cmp(num, tree[k]);
+            k = 2 * k + right;
+        }
+        k >>= __builtin_ctzll(~static_cast<unsigned long long>(k)) + 1;
+        return const_cast<T *>(k ? source + rank[k] : source + count);
+    }
+
+public:
+    eytzinger_index(const T *begin, const T *end, Compare cmp = Compare())
+            : source(begin), count(end - begin), cmp(cmp){
+        tree = static_cast<T *>(::operator new(sizeof(T) * (count + 1)));
+        try{
+            rank = new size_t[count + 1];
+        } catch (...){
+            ::operator delete(tree);
+            throw;
+        }
+        size_t next = 0;
+        try{
+            build(1, next);
+        } catch (...){
+            destroy(1, next);
+            ::operator delete(tree);
+            delete[] rank;
+            throw;
+        }
+    }
+
+    ~eytzinger_index(){
+        for (size_t k = 1; k <= count; ++k) tree[k].~T();
+        ::operator delete(tree);
+        delete[] rank;
+    }
+
+    eytzinger_index(const eytzinger_index &) = delete;
+    eytzinger_index &operator=(const eytzinger_index &) = delete;
+
+    size_t size() const{
+        return count;
+    }
+
+    /**
+     * same result as sjtu::lower_bound on the source array
+     */
+    T *lower_bound(const T &num) const{
+        return search<true>(num);
+    }
+
+    T *upper_bound(const T &num) const{
+        return search<false>(num);
+    }
+};
+
 };
 
 #endif //SJTU_ALGORITHM_HPP
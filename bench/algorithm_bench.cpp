@@ -0,0 +1,540 @@
+/**
+ * algorithm_bench: sjtu::sort / stable_sort / lower_bound / upper_bound from
+ * algorithm.hpp against their std:: counterparts.
+ *
+ * Sorting runs on int arrays drawn from these distributions:
+ *   sorted, reverse, organ_pipe (ascending then descending), many_dups
+ *   (16 distinct values), all_equal, random, median3_killer (Musser's
+ *   sequence against median-of-3 pivots) and antiqsort (McIlroy's
+ *   adversary, generated against each implementation itself).
+ * sjtu::sort without a comparator runs the vector kernel of simd_sort.hpp
+ * (the impl name says which one); the other sorts all take a comparator.
+ * Besides time, every comparison sort case reports the comparisons, element moves (copy /
+ * move constructions and assignments) and the deepest stack use of the
+ * comparator below the caller, which tracks recursion depth. These come
+ * from one extra instrumented run per case, outside the timed samples.
+ *
+ * A sort that needs more than 32 n log2 n comparisons on an input is
+ * degenerate there: the instrumented run stops at that budget, the case is
+ * listed as skipped instead of timed, and larger sizes of the same input
+ * are skipped too (they would take quadratic time and could overflow the
+ * stack). antiqsort inputs are only generated up to 3e4 elements, since
+ * the adversary itself runs the quadratic sort, unless --uncapped is given.
+ *
+ * Searching looks up 1e6 keys (half of them present) in a sorted array,
+ * either in random order or in ascending order, with the plain bounds,
+ * sjtu::eytzinger_index and the batched sjtu::lower_bound_many.
+ *
+ * Every sorted result and every search answer is checked against std::;
+ * the exit status is 1 on a mismatch. --perf adds hardware counters as in
+ * list_bench.
+ */
+
+#include "algorithm.hpp"
+#include "bench.hpp"
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+enum Distribution {
+    Sorted, Reverse, OrganPipe, ManyDups, AllEqual, Random, Median3Killer, Antiqsort, DistributionCount
+};
+
+const char *distributionName(int d) {
+    static const char *names[DistributionCount] = {
+        "sorted", "reverse", "organ_pipe", "many_dups", "all_equal", "random", "median3_killer", "antiqsort"
+    };
+    return names[d];
+}
+
+const size_t ANTIQSORT_CAP = 30000;
+const size_t QUERIES = 1000000;
+
+bool mismatch = false;
+
+/**
+ * element that counts its copies; compared through the counting comparator.
+ */
+struct Tracked {
+    int value;
+    static size_t moves;
+
+    Tracked() : value(0) {}
+
+    explicit Tracked(int value) : value(value) {}
+
+    Tracked(const Tracked &other) : value(other.value) {
+        ++moves;
+    }
+
+    Tracked &operator=(const Tracked &other) {
+        value = other.value;
+        ++moves;
+        return *this;
+    }
+};
+
+size_t Tracked::moves = 0;
+
+struct BudgetExceeded {};
+
+struct Counts {
+    size_t comparisons = 0;
+    size_t moves = 0;
+    size_t stackBytes = 0;
+    bool degenerate = false;
+};
+
+/**
+ * counting comparator: throws BudgetExceeded past the budget and records
+ * how far below base the stack has grown.
+ */
+class Counter {
+private:
+    size_t budget;
+    uintptr_t base;
+
+public:
+    size_t comparisons;
+    uintptr_t lowest;
+
+    Counter(size_t budget, uintptr_t base) : budget(budget), base(base), comparisons(0), lowest(base) {}
+
+    bool compare(const Tracked &a, const Tracked &b) {
+        uintptr_t here = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+        if (here < lowest) lowest = here;
+        if (++comparisons > budget) throw BudgetExceeded();
+        return a.value < b.value;
+    }
+
+    size_t stackBytes() const {
+        return base - lowest;
+    }
+};
+
+struct SjtuSort {
+    static const bool COMPARISON_BASED = true;
+
+    static const char *name() {
+        return "sjtu::sort";
+    }
+
+    static void sort(int *begin, int *end) {
+        sjtu::sort<int>(begin, end, [](const int &a, const int &b) { return a < b; });
+    }
+
+    template<typename T, typename Cmp>
+    static void sortWith(T *begin, T *end, Cmp cmp) {
+        sjtu::sort<T>(begin, end, cmp);
+    }
+};
+
+/**
+ * sjtu::sort without a comparator, i.e. the vector kernel of simd_sort.hpp
+ * where the CPU has one. It compares no elements through a comparator, so
+ * there are no counts and no antiqsort input for it.
+ */
+struct SjtuSimdSort {
+    static const bool COMPARISON_BASED = false;
+
+    static const char *name() {
+        return sjtu::simd::detected() == sjtu::simd::AVX2 ? "sjtu::sort(avx2)" :
+               sjtu::simd::detected() == sjtu::simd::SSE42 ? "sjtu::sort(sse4.2)" : "sjtu::sort(scalar)";
+    }
+
+    static void sort(int *begin, int *end) {
+        sjtu::sort(begin, end);
+    }
+
+    template<typename T, typename Cmp>
+    static void sortWith(T *begin, T *end, Cmp cmp) {
+        sjtu::sort<T>(begin, end, cmp);
+    }
+};
+
+struct StdSort {
+    static const bool COMPARISON_BASED = true;
+
+    static const char *name() {
+        return "std::sort";
+    }
+
+    static void sort(int *begin, int *end) {
+        std::sort(begin, end);
+    }
+
+    template<typename T, typename Cmp>
+    static void sortWith(T *begin, T *end, Cmp cmp) {
+        std::sort(begin, end, cmp);
+    }
+};
+
+struct SjtuStableSort {
+    static const bool COMPARISON_BASED = true;
+
+    static const char *name() {
+        return "sjtu::stable_sort";
+    }
+
+    static void sort(int *begin, int *end) {
+        sjtu::stable_sort(begin, end, std::less<int>());  // the merge sort, not the int kernels
+    }
+
+    template<typename T, typename Cmp>
+    static void sortWith(T *begin, T *end, Cmp cmp) {
+        sjtu::stable_sort(begin, end, cmp);
+    }
+};
+
+struct StdStableSort {
+    static const bool COMPARISON_BASED = true;
+
+    static const char *name() {
+        return "std::stable_sort";
+    }
+
+    static void sort(int *begin, int *end) {
+        std::stable_sort(begin, end);
+    }
+
+    template<typename T, typename Cmp>
+    static void sortWith(T *begin, T *end, Cmp cmp) {
+        std::stable_sort(begin, end, cmp);
+    }
+};
+
+/**
+ * McIlroy's "A Killer Adversary for Quicksort": sort indices while values
+ * are decided lazily. Everything starts as "gas" (larger than any solid
+ * value); whenever two gas items meet, one of them is frozen to the next
+ * solid value, preferring the item the algorithm keeps using as pivot.
+ * The final values are an input on which that (deterministic) sort is
+ * quadratic.
+ */
+template<typename Impl>
+void antiqsort(size_t n, std::vector<int> &out) {
+    std::vector<int> val(n, static_cast<int>(n));
+    std::vector<int> ptr(n);
+    for (size_t i = 0; i < n; ++i) ptr[i] = static_cast<int>(i);
+    const int gas = static_cast<int>(n);
+    int solid = 0, candidate = 0;
+    Impl::sortWith(ptr.data(), ptr.data() + n, [&](const int &x, const int &y) {
+        if (val[x] == gas && val[y] == gas) {
+            if (x == candidate) {
+                val[x] = solid++;
+            } else {
+                val[y] = solid++;
+            }
+        }
+        if (val[x] == gas) {
+            candidate = x;
+        } else if (val[y] == gas) {
+            candidate = y;
+        }
+        return val[x] < val[y];
+    });
+    out = val;
+}
+
+template<typename Impl>
+void generate(int d, size_t n, std::vector<int> &out) {
+    std::mt19937 rng(static_cast<unsigned>(n * 31 + d));
+    out.assign(n, 0);
+    switch (d) {
+        case Sorted:
+            for (size_t i = 0; i < n; ++i) out[i] = static_cast<int>(i);
+            break;
+        case Reverse:
+            for (size_t i = 0; i < n; ++i) out[i] = static_cast<int>(n - i);
+            break;
+        case OrganPipe:
+            for (size_t i = 0; i < n; ++i) out[i] = static_cast<int>(i < n / 2 ? i : n - 1 - i);
+            break;
+        case ManyDups:
+            for (size_t i = 0; i < n; ++i) out[i] = static_cast<int>(rng() % 16);
+            break;
+        case AllEqual:
+            break;
+        case Random:
+            for (size_t i = 0; i < n; ++i) out[i] = static_cast<int>(rng() >> 1);
+            break;
+        case Median3Killer: {
+            // Musser, "Introspective Sorting and Selection Algorithms"
+            size_t k = n / 2;
+            for (size_t i = 1; i <= k; ++i) {
+                if (i % 2 == 1) {
+                    out[i - 1] = static_cast<int>(i);
+                    out[i] = static_cast<int>(k + i);
+                }
+                out[k + i - 1] = static_cast<int>(2 * i);
+            }
+            if (n % 2) out[n - 1] = static_cast<int>(n);
+            break;
+        }
+        case Antiqsort:
+            antiqsort<Impl>(n, out);
+            break;
+    }
+}
+
+/**
+ * one instrumented run of Impl on input; stops at the comparison budget.
+ */
+template<typename Impl>
+Counts instrument(const std::vector<int> &input) {
+    size_t n = input.size();
+    std::vector<Tracked> data(n);
+    for (size_t i = 0; i < n; ++i) data[i].value = input[i];
+    Counts c;
+    size_t budget = static_cast<size_t>(32.0 * n * std::log2(n + 1.0)) + 64;
+    Counter counter(budget, reinterpret_cast<uintptr_t>(__builtin_frame_address(0)));
+    Tracked::moves = 0;
+    try {
+        Impl::sortWith(data.data(), data.data() + n,
+                       [&](const Tracked &a, const Tracked &b) { return counter.compare(a, b); });
+    } catch (BudgetExceeded &) {
+        c.degenerate = true;
+    }
+    c.comparisons = counter.comparisons;
+    c.moves = Tracked::moves;
+    c.stackBytes = counter.stackBytes();
+    return c;
+}
+
+/**
+ * reports the counts of the instrumented run next to the timings.
+ */
+class CountProbe : public bench::Probe {
+public:
+    Counts counts;
+    bool active = false;
+
+    void reset() override {}
+
+    void start() override {}
+
+    void stop() override {}
+
+    void collect(bench::Metrics &metrics) override {
+        if (!active) return;
+        metrics.push_back(std::make_pair("comparisons", static_cast<double>(counts.comparisons)));
+        metrics.push_back(std::make_pair("moves", static_cast<double>(counts.moves)));
+        metrics.push_back(std::make_pair("stack_bytes", static_cast<double>(counts.stackBytes)));
+    }
+};
+
+template<typename Impl>
+void runSorts(bench::Runner &runner, CountProbe &probe) {
+    const bench::Options &opts = runner.options();
+    bool degenerate[DistributionCount] = {};
+    for (int d = 0; d < DistributionCount; ++d) {
+        for (size_t n : opts.sizes) {
+            bench::Case c = {"sort", Impl::name(), "int", distributionName(d), n, n};
+            if (!runner.enabled(c)) continue;
+            if (degenerate[d]) {
+                runner.skip(c, "degenerate at a smaller size");
+                continue;
+            }
+            if (d == Antiqsort && !Impl::COMPARISON_BASED) {
+                runner.skip(c, "antiqsort needs a comparator to attack");
+                continue;
+            }
+            if (d == Antiqsort && n > ANTIQSORT_CAP && !opts.uncapped) {
+                runner.skip(c, "antiqsort generation is quadratic, use --uncapped");
+                continue;
+            }
+            std::vector<int> input;
+            generate<Impl>(d, n, input);
+            probe.counts = Impl::COMPARISON_BASED ? instrument<Impl>(input) : Counts();
+            if (probe.counts.degenerate) {
+                degenerate[d] = true;
+                runner.skip(c, "more than 32 n log2 n comparisons");
+                continue;
+            }
+            std::vector<int> expected = input;
+            std::sort(expected.begin(), expected.end());
+            std::vector<int> work;
+            probe.active = Impl::COMPARISON_BASED;
+            runner.run(c, [&](bench::Stopwatch &sw) {
+                work = input;
+                sw.start();
+                Impl::sort(work.data(), work.data() + n);
+                sw.stop();
+            });
+            probe.active = false;
+            if (work != expected) {
+                fprintf(stderr, "%s: wrong result\n", c.name().c_str());
+                mismatch = true;
+            }
+        }
+    }
+}
+
+/**
+ * search implementations are built once per array (the Eytzinger index
+ * re-lays it) and answer a batch of keys with the sum of the positions.
+ */
+template<typename Derived>
+struct PerKey {
+    const std::vector<int> &a;
+
+    explicit PerKey(const std::vector<int> &a) : a(a) {}
+
+    size_t sum(const std::vector<int> &keys) const {
+        size_t total = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            total += static_cast<const Derived *>(this)->find(keys[i]) - a.data();
+        }
+        return total;
+    }
+};
+
+struct SjtuLowerBound : PerKey<SjtuLowerBound> {
+    static const char *name() {
+        return "sjtu::lower_bound";
+    }
+
+    explicit SjtuLowerBound(const std::vector<int> &a) : PerKey(a) {}
+
+    const int *find(int key) const {
+        return sjtu::lower_bound<int>(a.data(), a.data() + a.size(), key);
+    }
+};
+
+struct StdLowerBound : PerKey<StdLowerBound> {
+    static const char *name() {
+        return "std::lower_bound";
+    }
+
+    explicit StdLowerBound(const std::vector<int> &a) : PerKey(a) {}
+
+    const int *find(int key) const {
+        return std::lower_bound(a.data(), a.data() + a.size(), key);
+    }
+};
+
+struct SjtuUpperBound : PerKey<SjtuUpperBound> {
+    static const char *name() {
+        return "sjtu::upper_bound";
+    }
+
+    explicit SjtuUpperBound(const std::vector<int> &a) : PerKey(a) {}
+
+    const int *find(int key) const {
+        return sjtu::upper_bound<int>(a.data(), a.data() + a.size(), key);
+    }
+};
+
+struct StdUpperBound : PerKey<StdUpperBound> {
+    static const char *name() {
+        return "std::upper_bound";
+    }
+
+    explicit StdUpperBound(const std::vector<int> &a) : PerKey(a) {}
+
+    const int *find(int key) const {
+        return std::upper_bound(a.data(), a.data() + a.size(), key);
+    }
+};
+
+struct EytzingerLowerBound : PerKey<EytzingerLowerBound> {
+    sjtu::eytzinger_index<int> index;
+
+    static const char *name() {
+        return "sjtu::eytzinger_index";
+    }
+
+    explicit EytzingerLowerBound(const std::vector<int> &a) : PerKey(a), index(a.data(), a.data() + a.size()) {}
+
+    const int *find(int key) const {
+        return index.lower_bound(key);
+    }
+};
+
+struct SjtuLowerBoundMany {
+    const std::vector<int> &a;
+    mutable std::vector<int *> out;
+
+    static const char *name() {
+        return "sjtu::lower_bound_many";
+    }
+
+    explicit SjtuLowerBoundMany(const std::vector<int> &a) : a(a) {}
+
+    size_t sum(const std::vector<int> &keys) const {
+        out.resize(keys.size());
+        sjtu::lower_bound_many(a.data(), a.data() + a.size(), keys.data(), keys.data() + keys.size(), out.data());
+        size_t total = 0;
+        for (size_t i = 0; i < out.size(); ++i) total += out[i] - a.data();
+        return total;
+    }
+};
+
+/**
+ * the array holds the even numbers 0, 2, .., 2n-2 (n up to 1e8 fits an
+ * int), so odd keys miss and even keys hit.
+ */
+template<typename Impl, typename Reference>
+void runSearch(bench::Runner &runner) {
+    for (size_t n : runner.options().sizes) {
+        std::vector<int> array(n);
+        for (size_t i = 0; i < n; ++i) array[i] = static_cast<int>(2 * i);
+        std::mt19937 rng(static_cast<unsigned>(n));
+        std::vector<int> keys(QUERIES);
+        for (size_t i = 0; i < QUERIES; ++i) keys[i] = static_cast<int>(rng() % (2 * n + 1)) - 1;
+        Impl impl(array);
+        Reference reference(array);
+        for (int order = 0; order < 2; ++order) {
+            if (order == 1) std::sort(keys.begin(), keys.end());
+            bench::Case c = {"search", Impl::name(), "int", order ? "ascending_keys" : "random_keys", n, QUERIES};
+            if (!runner.enabled(c)) continue;
+            size_t checksum = 0;
+            runner.run(c, [&](bench::Stopwatch &sw) {
+                sw.start();
+                size_t sum = impl.sum(keys);
+                sw.stop();
+                bench::doNotOptimize(sum);
+                checksum = sum;
+            });
+            if (checksum != reference.sum(keys)) {
+                fprintf(stderr, "%s: wrong positions\n", c.name().c_str());
+                mismatch = true;
+            }
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    bench::Options opts = bench::parseOptions(argc, argv, {1000, 10000, 100000, 1000000});
+    bench::Runner runner(opts);
+    CountProbe probe;
+    runner.addProbe(&probe);
+    std::unique_ptr<bench::PerfCounters> perfProbe;
+    if (opts.perf) {
+        perfProbe.reset(new bench::PerfCounters());
+        runner.addProbe(perfProbe.get());
+    }
+    runSorts<SjtuSort>(runner, probe);
+    runSorts<SjtuSimdSort>(runner, probe);
+    runSorts<StdSort>(runner, probe);
+    runSorts<SjtuStableSort>(runner, probe);
+    runSorts<StdStableSort>(runner, probe);
+    runSearch<SjtuLowerBound, StdLowerBound>(runner);
+    runSearch<StdLowerBound, StdLowerBound>(runner);
+    runSearch<SjtuUpperBound, StdUpperBound>(runner);
+    runSearch<StdUpperBound, StdUpperBound>(runner);
+    runSearch<EytzingerLowerBound, StdLowerBound>(runner);
+    runSearch<SjtuLowerBoundMany, StdLowerBound>(runner);
+    if (!runner.report()) return 1;
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+#include "alloc_counter.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace alloc {
+
+namespace {
+
+const size_t MAX_DEPTH = 32;
+const size_t MAX_NAMES = 64;
+// keeps the user pointer 16-byte aligned while remembering the request size
+const size_t HEADER = 16;
+
+struct Region {
+    const char *name;
+    size_t liveAtEntry;
+    Stats stats;
+};
+
+struct Total {
+    const char *name;
+    size_t runs;
+    Stats stats;
+};
+
+Region regions[MAX_DEPTH];
+size_t depth = 0;
+Total totalsTable[MAX_NAMES];
+size_t names = 0;
+size_t live = 0;
+size_t violationCount = 0;
+
+void noteAllocation(size_t size) {
+    live += size;
+    for (size_t i = 0; i < depth; ++i) {
+        Stats &s = regions[i].stats;
+        ++s.allocations;
+        s.bytes += size;
+        if (live > regions[i].liveAtEntry && live - regions[i].liveAtEntry > s.peakLive) {
+            s.peakLive = live - regions[i].liveAtEntry;
+        }
+    }
+}
+
+void noteFree(size_t size) {
+    live -= size;
+    for (size_t i = 0; i < depth; ++i) {
+        ++regions[i].stats.frees;
+    }
+}
+
+Total *lookup(const char *name) {
+    for (size_t i = 0; i < names; ++i) {
+        if (strcmp(totalsTable[i].name, name) == 0) return &totalsTable[i];
+    }
+    if (names == MAX_NAMES) return nullptr;
+    totalsTable[names].name = name;
+    return &totalsTable[names++];
+}
+
+void reportAtExit() {
+    report(stderr);
+}
+
+struct ExitHook {
+    ExitHook() {
+        if (getenv("ALLOC_COUNTER_REPORT") != nullptr) atexit(reportAtExit);
+    }
+} exitHook;
+
+}
+
+void begin(const char *name) {
+    if (depth == MAX_DEPTH) abort();
+    regions[depth].name = name;
+    regions[depth].liveAtEntry = live;
+    regions[depth].stats = Stats();
+    ++depth;
+}
+
+Stats end() {
+    if (depth == 0) abort();
+    Region &r = regions[--depth];
+    Total *t = lookup(r.name);
+    if (t != nullptr) {
+        ++t->runs;
+        t->stats.allocations += r.stats.allocations;
+        t->stats.frees += r.stats.frees;
+        t->stats.bytes += r.stats.bytes;
+        if (r.stats.peakLive > t->stats.peakLive) t->stats.peakLive = r.stats.peakLive;
+    }
+    return r.stats;
+}
+
+size_t liveBytes() {
+    return live;
+}
+
+Stats totals(const char *name, size_t *runs) {
+    for (size_t i = 0; i < names; ++i) {
+        if (strcmp(totalsTable[i].name, name) == 0) {
+            if (runs != nullptr) *runs = totalsTable[i].runs;
+            return totalsTable[i].stats;
+        }
+    }
+    if (runs != nullptr) *runs = 0;
+    return Stats();
+}
+
+size_t violations() {
+    return violationCount;
+}
+
+void report(FILE *out) {
+    fprintf(out, "%-24s %8s %12s %8s %14s %14s\n", "region", "runs", "allocations", "frees", "bytes", "peak live");
+    for (size_t i = 0; i < names; ++i) {
+        const Total &t = totalsTable[i];
+        fprintf(out, "%-24s %8zu %12zu %8zu %14zu %14zu\n", t.name, t.runs, t.stats.allocations, t.stats.frees,
+                t.stats.bytes, t.stats.peakLive);
+    }
+    if (violationCount) fprintf(out, "%zu region(s) allocated although they must not\n", violationCount);
+}
+
+bool ExpectNoAlloc::check() {
+    bool wasOpen = open;
+    const Stats &s = close();
+    if (wasOpen && s.allocations) {
+        ++violationCount;
+        fprintf(stderr, "alloc: '%s' must not allocate but made %zu allocation(s) of %zu bytes\n", name,
+                s.allocations, s.bytes);
+    }
+    return s.allocations == 0;
+}
+
+}
+
+void *operator new(size_t size) {
+    void *p = malloc(size + alloc::HEADER);
+    if (p == nullptr) throw std::bad_alloc();
+    *static_cast<size_t *>(p) = size;
+    alloc::noteAllocation(size);
+    return static_cast<char *>(p) + alloc::HEADER;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    if (ptr == nullptr) return;
+    void *p = static_cast<char *>(ptr) - alloc::HEADER;
+    alloc::noteFree(*static_cast<size_t *>(p));
+    free(p);
+}
+
+void operator delete[](void *ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    operator delete(ptr);
+}
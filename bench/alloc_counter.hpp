@@ -0,0 +1,104 @@
+#ifndef SJTU_ALLOC_COUNTER_HPP
+#define SJTU_ALLOC_COUNTER_HPP
+
+#include <cstddef>
+#include <cstdio>
+
+/**
+ * Test-side heap accounting. Linking alloc_counter.cpp replaces the global
+ * operator new / operator delete; every allocation is then attributed to
+ * all currently open regions.
+ *
+ * Regions are named and nest; the stats of every region are also summed
+ * per name, so "sort" can be opened many times and reported once. An
+ * ExpectNoAlloc region records a violation when anything allocates inside
+ * it. Not thread-safe: the drivers that use it are single-threaded.
+ */
+namespace alloc {
+
+struct Stats {
+    size_t allocations = 0;
+    size_t frees = 0;
+    size_t bytes = 0;     // bytes requested by the allocations
+    size_t peakLive = 0;  // high-water mark of live bytes above the level at region entry
+};
+
+/**
+ * open a region; name must outlive the program (a string literal).
+ */
+void begin(const char *name);
+
+/**
+ * close the innermost region and return what happened inside it.
+ */
+Stats end();
+
+/**
+ * bytes currently live through operator new.
+ */
+size_t liveBytes();
+
+/**
+ * summed stats of all closed regions called name, and how often it was opened.
+ */
+Stats totals(const char *name, size_t *runs = nullptr);
+
+/**
+ * number of ExpectNoAlloc regions that allocated.
+ */
+size_t violations();
+
+/**
+ * print the per-name table. Also done at exit when ALLOC_COUNTER_REPORT is set.
+ */
+void report(FILE *out);
+
+class Scope {
+protected:
+    Stats result;
+    bool open;
+
+public:
+    explicit Scope(const char *name) : open(true) {
+        begin(name);
+    }
+
+    /**
+     * close the region early and return its stats.
+     */
+    const Stats &close() {
+        if (open) {
+            result = end();
+            open = false;
+        }
+        return result;
+    }
+
+    ~Scope() {
+        close();
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+};
+
+class ExpectNoAlloc : public Scope {
+private:
+    const char *name;
+
+public:
+    explicit ExpectNoAlloc(const char *name) : Scope(name), name(name) {}
+
+    /**
+     * close the region; returns false (and records a violation) if it allocated.
+     */
+    bool check();
+
+    ~ExpectNoAlloc() {
+        check();
+    }
+};
+
+}
+
+#endif //SJTU_ALLOC_COUNTER_HPP
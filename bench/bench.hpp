@@ -0,0 +1,344 @@
+#ifndef SJTU_BENCH_HPP
+#define SJTU_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A small self-contained timing harness shared by the benchmark drivers.
+ *
+ * Every case runs `warmup` untimed rounds followed by `repetitions` timed
+ * samples. The body receives a Stopwatch and decides itself which part is
+ * charged to the sample, so building inputs never pollutes the numbers.
+ * Results are printed as a table on stderr while running and written as
+ * JSON at the end, which is what gets diffed between commits.
+ */
+namespace bench {
+
+typedef std::vector<std::pair<std::string, double>> Metrics;
+
+/**
+ * something measured alongside the time (heap traffic, hardware counters).
+ * start()/stop() bracket exactly the timed part of a sample.
+ */
+class Probe {
+public:
+    virtual ~Probe() {}
+
+    /**
+     * called before every sample.
+     */
+    virtual void reset() = 0;
+
+    virtual void start() = 0;
+
+    virtual void stop() = 0;
+
+    /**
+     * append the values gathered since the last reset(), the same names in
+     * the same order for every sample. A negative value means "unknown".
+     */
+    virtual void collect(Metrics &metrics) = 0;
+};
+
+class Stopwatch {
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point begin;
+    double elapsed;  // nanoseconds
+    const std::vector<Probe *> *probes;
+
+public:
+    explicit Stopwatch(const std::vector<Probe *> *probes = nullptr) : elapsed(0), probes(probes) {}
+
+    void reset() {
+        elapsed = 0;
+        if (probes) {
+            for (size_t i = 0; i < probes->size(); ++i) (*probes)[i]->reset();
+        }
+    }
+
+    void start() {
+        if (probes) {
+            for (size_t i = 0; i < probes->size(); ++i) (*probes)[i]->start();
+        }
+        begin = clock::now();
+    }
+
+    void stop() {
+        clock::time_point end = clock::now();
+        elapsed += std::chrono::duration<double, std::nano>(end - begin).count();
+        if (probes) {
+            for (size_t i = probes->size(); i-- > 0;) (*probes)[i]->stop();
+        }
+    }
+
+    double nanoseconds() const {
+        return elapsed;
+    }
+};
+
+/**
+ * keeps a value alive so the optimizer cannot drop the work producing it.
+ */
+template<typename T>
+inline void doNotOptimize(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Case {
+    std::string suite;
+    std::string impl;
+    std::string type;
+    std::string op;
+    size_t n;
+    size_t ops;  // operations performed by one sample, used for ns/op
+
+    std::string name() const {
+        return suite + "/" + impl + "/" + type + "/" + op + "/" + std::to_string(n);
+    }
+};
+
+struct Result {
+    Case meta;
+    std::vector<double> samples;
+    double min, median, p99, mean, nsPerOp;
+    Metrics metrics;  // median over the samples of every probe value, -1 if never known
+};
+
+struct Options {
+    int warmup = 1;
+    int repetitions = 5;
+    std::vector<size_t> sizes;
+    std::string filter;
+    std::string output;
+    std::string label;
+    bool uncapped = false;
+    bool perf = false;  // hardware counters, see perf_counters.hpp
+};
+
+inline void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --warmup N         untimed rounds per case (default 1)\n"
+            "  --reps N           timed samples per case (default 5)\n"
+            "  --sizes A,B,...    element counts to run\n"
+            "  --filter STR       only run cases whose name contains STR\n"
+            "  --uncapped         ignore the per-type size caps\n"
+            "  --perf             read hardware counters (cycles, instructions, cache and branch misses)\n"
+            "  --label STR        free-form tag stored in the JSON (e.g. a commit)\n"
+            "  --out FILE         write JSON to FILE instead of stdout\n",
+            prog);
+}
+
+inline std::vector<size_t> parseSizes(const char *s) {
+    std::vector<size_t> sizes;
+    while (*s) {
+        char *end = nullptr;
+        double v = strtod(s, &end);
+        if (end == s) break;
+        sizes.push_back(static_cast<size_t>(v));
+        s = *end == ',' ? end + 1 : end;
+    }
+    return sizes;
+}
+
+/**
+ * parse the common command line; exits on --help or malformed input.
+ */
+inline Options parseOptions(int argc, char **argv, const std::vector<size_t> &defaultSizes) {
+    Options opts;
+    opts.sizes = defaultSizes;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--warmup" && hasValue) {
+            opts.warmup = atoi(argv[++i]);
+        } else if (arg == "--reps" && hasValue) {
+            opts.repetitions = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--sizes" && hasValue) {
+            opts.sizes = parseSizes(argv[++i]);
+        } else if (arg == "--filter" && hasValue) {
+            opts.filter = argv[++i];
+        } else if (arg == "--label" && hasValue) {
+            opts.label = argv[++i];
+        } else if (arg == "--out" && hasValue) {
+            opts.output = argv[++i];
+        } else if (arg == "--uncapped") {
+            opts.uncapped = true;
+        } else if (arg == "--perf") {
+            opts.perf = true;
+        } else {
+            usage(argv[0]);
+            exit(arg == "--help" || arg == "-h" ? 0 : 2);
+        }
+    }
+    return opts;
+}
+
+inline std::string jsonEscape(const std::string &s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+class Runner {
+private:
+    Options opts;
+    std::vector<Result> results;
+    std::vector<std::pair<std::string, std::string>> skipped;  // case name, reason
+    std::vector<Probe *> probes;
+
+    static double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        size_t n = values.size();
+        return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    }
+
+    static double percentile(const std::vector<double> &sorted, double p) {
+        size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+        if (rank == 0) rank = 1;
+        if (rank > sorted.size()) rank = sorted.size();
+        return sorted[rank - 1];
+    }
+
+public:
+    explicit Runner(const Options &opts) : opts(opts) {}
+
+    const Options &options() const {
+        return opts;
+    }
+
+    /**
+     * attach a probe to every following case; the runner does not own it.
+     */
+    void addProbe(Probe *probe) {
+        probes.push_back(probe);
+    }
+
+    bool enabled(const Case &c) const {
+        return opts.filter.empty() || c.name().find(opts.filter) != std::string::npos;
+    }
+
+    /**
+     * run body(Stopwatch &) warmup + repetitions times and record the samples.
+     */
+    template<typename Body>
+    void run(const Case &c, Body body) {
+        if (!enabled(c)) return;
+        Stopwatch sw(&probes);
+        for (int i = 0; i < opts.warmup; ++i) {
+            sw.reset();
+            body(sw);
+        }
+        Result r;
+        r.meta = c;
+        std::vector<Metrics> perSample;
+        for (int i = 0; i < opts.repetitions; ++i) {
+            sw.reset();
+            body(sw);
+            r.samples.push_back(sw.nanoseconds());
+            perSample.push_back(Metrics());
+            for (size_t j = 0; j < probes.size(); ++j) probes[j]->collect(perSample.back());
+        }
+        for (size_t k = 0; k < perSample.front().size(); ++k) {
+            std::vector<double> values;
+            for (size_t i = 0; i < perSample.size(); ++i) {
+                if (perSample[i][k].second >= 0) values.push_back(perSample[i][k].second);
+            }
+            r.metrics.push_back(std::make_pair(perSample.front()[k].first, values.empty() ? -1 : median(values)));
+        }
+        std::vector<double> sorted = r.samples;
+        std::sort(sorted.begin(), sorted.end());
+        r.min = sorted.front();
+        r.median = median(sorted);
+        r.p99 = percentile(sorted, 0.99);
+        r.mean = 0;
+        for (double s : sorted) r.mean += s;
+        r.mean /= sorted.size();
+        r.nsPerOp = c.ops ? r.median / c.ops : r.median;
+        fprintf(stderr, "%-60s median %12.0f ns  p99 %12.0f ns  %10.2f ns/op",
+                c.name().c_str(), r.median, r.p99, r.nsPerOp);
+        for (size_t j = 0; j < r.metrics.size(); ++j) {
+            fprintf(stderr, "  %s %.4g", r.metrics[j].first.c_str(), r.metrics[j].second);
+        }
+        fprintf(stderr, "\n");
+        results.push_back(r);
+    }
+
+    /**
+     * note a case that was not run and why; listed under "skipped" in the JSON.
+     */
+    void skip(const Case &c, const std::string &reason) {
+        if (!enabled(c)) return;
+        fprintf(stderr, "%-60s skipped: %s\n", c.name().c_str(), reason.c_str());
+        skipped.push_back(std::make_pair(c.name(), reason));
+    }
+
+    void writeJson(std::ostream &os) const {
+        os.precision(12);
+        os << "{\n  \"label\": \"" << jsonEscape(opts.label) << "\",\n";
+        os << "  \"context\": {\"compiler\": \"" << jsonEscape(__VERSION__) << "\", "
+           << "\"warmup\": " << opts.warmup << ", \"repetitions\": " << opts.repetitions << "},\n";
+        os << "  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result &r = results[i];
+            os << (i ? ",\n    " : "\n    ");
+            os << "{\"suite\": \"" << jsonEscape(r.meta.suite) << "\", \"impl\": \"" << jsonEscape(r.meta.impl)
+               << "\", \"type\": \"" << jsonEscape(r.meta.type) << "\", \"op\": \"" << jsonEscape(r.meta.op)
+               << "\", \"n\": " << r.meta.n << ", \"ops\": " << r.meta.ops
+               << ", \"min_ns\": " << r.min << ", \"median_ns\": " << r.median << ", \"p99_ns\": " << r.p99
+               << ", \"mean_ns\": " << r.mean << ", \"ns_per_op\": " << r.nsPerOp;
+            for (size_t j = 0; j < r.metrics.size(); ++j) {
+                os << ", \"" << jsonEscape(r.metrics[j].first) << "\": " << r.metrics[j].second;
+            }
+            os << ", \"samples_ns\": [";
+            for (size_t j = 0; j < r.samples.size(); ++j) {
+                os << (j ? ", " : "") << r.samples[j];
+            }
+            os << "]}";
+        }
+        os << "\n  ]";
+        if (!skipped.empty()) {
+            os << ",\n  \"skipped\": [";
+            for (size_t i = 0; i < skipped.size(); ++i) {
+                os << (i ? ",\n    " : "\n    ") << "{\"case\": \"" << jsonEscape(skipped[i].first)
+                   << "\", \"reason\": \"" << jsonEscape(skipped[i].second) << "\"}";
+            }
+            os << "\n  ]";
+        }
+        os << "\n}\n";
+    }
+
+    /**
+     * write the JSON report to --out, or stdout when no file was given.
+     */
+    bool report() const {
+        if (opts.output.empty()) {
+            writeJson(std::cout);
+            return true;
+        }
+        std::ofstream out(opts.output.c_str());
+        if (!out) {
+            fprintf(stderr, "cannot open %s\n", opts.output.c_str());
+            return false;
+        }
+        writeJson(out);
+        return true;
+    }
+};
+
+}
+
+#endif //SJTU_BENCH_HPP
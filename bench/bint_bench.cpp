@@ -0,0 +1,482 @@
+/**
+ * bint_bench: the multiplication, division and modular exponentiation
+ * kernels, the carry and comparison kernels, the accumulation operators
+ * and the decimal I/O of class-bint.hpp on operands of a given number of
+ * decimal digits.
+ *
+ * Suite "mul" multiplies two random numbers of n digits each ("square"
+ * shape) and an n-digit number by one of n / 8 digits ("unbalanced").
+ * The impls are:
+ *   legacy      the schoolbook loop operator* used before, which divides
+ *               and takes the remainder after every limb product, on the
+ *               base 10^4 limbs Bint used then (converted outside the timing)
+ *   schoolbook  BintKernel::mulSchoolbook, carries deferred per column
+ *   karatsuba   BintKernel::mulKaratsuba
+ *   toom3       BintKernel::mulToom3
+ *   ntt         BintKernel::mulNtt, the number-theoretic transform
+ *   multiply    BintKernel::multiply, the size-selected path of operator*
+ * The quadratic impls stop at SCHOOLBOOK_CAP digits unless --uncapped is
+ * given. Every product is checked against multiply(), whose own
+ * exactness is covered by data/bint.
+ *
+ * Suite "accumulate" sums ACCUMULATE_TERMS Bints of n digits with
+ * alternating signs, as "sum = sum + x" (operator+) and as "sum += x"
+ * (operator+=), up to ACCUMULATE_CAP digits unless --uncapped is given.
+ * Both sums are checked against each other.
+ *
+ * Suite "div" divides a random number of 2n digits by one of n digits:
+ *   knuth             BintKernel::divKnuth, Knuth's algorithm D
+ *   burnikel_ziegler  BintKernel::divBurnikelZiegler
+ *   divide            BintKernel::divide, the size-selected path of operator/
+ * knuth stops at SCHOOLBOOK_CAP digits unless --uncapped is given. Every
+ * quotient and remainder is checked by multiplying back.
+ *
+ * Suite "powmod" raises a random number to a random POWMOD_EXP_DIGITS-digit
+ * power modulo a random odd n-digit modulus not divisible by 5:
+ *   montgomery  BintKernel::powModMontgomery
+ *   divide      BintKernel::powModDivide, reducing each product by divide()
+ * up to POWMOD_CAP digits unless --uncapped is given. Both results are
+ * checked against each other.
+ *
+ * Suite "io" prints and parses IO_DIGITS / n values of n digits (at least
+ * one), alternating in sign and separated by spaces:
+ *   operator<<      into a std::ostringstream
+ *   toChars         Bint::toChars into one preallocated buffer
+ *   string_ctor     "in >> s" into a std::string, then Bint(s), the way
+ *                   operator>> used to read
+ *   operator>>      from a std::istringstream
+ * The printed texts must agree and the parsed values must equal the
+ * originals.
+ *
+ * Suite "carry" runs BintKernel::addCarry, subBorrow and compareLimbs on
+ * two random n-digit limb arrays (compare on two equal ones, which scans
+ * them whole), once per SIMD level the CPU has: scalar, sse4.2, avx2. The
+ * op count is the number of limbs. Sums and differences are checked
+ * against the scalar ones.
+ *
+ * Suite "literal" (independent of --sizes) seeds a vector with
+ * LITERAL_COPIES copies of the powers 3^40, 3^50, ..., 3^110 (20 to 53
+ * digits), constructed from strings and from _bint literals, whose limbs
+ * the compiler has already split. Both vectors are checked against each
+ * other. The exit status is 1 on any mismatch.
+ */
+
+#include "bench.hpp"
+#include "class-bint.hpp"
+#include "perf_counters.hpp"
+
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+using Util::BintKernel::limb;
+
+const size_t DIGITS_PER_LIMB = Util::BintKernel::BASE_DIGITS;
+const limb LEGACY_BASE = 10000;
+const size_t LEGACY_DIGITS = 4;
+const size_t SCHOOLBOOK_CAP = 200000;
+const size_t ACCUMULATE_TERMS = 1000;
+const size_t ACCUMULATE_CAP = 100000;
+const size_t POWMOD_EXP_DIGITS = 300;
+const size_t POWMOD_CAP = 10000;
+const size_t IO_DIGITS = 1000000;
+const size_t LITERAL_COPIES = 1000;
+
+bool mismatch = false;
+
+void legacyMul(const limb *a, size_t n, const limb *b, size_t m, limb *r) {
+    // the operands are in base LEGACY_BASE here
+    memset(r, 0, (n + m) * sizeof(limb));
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < m; ++j) {
+            long long tmp = r[i + j] + static_cast<long long>(a[i]) * b[j];
+            if (tmp >= LEGACY_BASE) {
+                r[i + j] = tmp % LEGACY_BASE;
+                r[i + j + 1] += static_cast<int>(tmp / LEGACY_BASE);
+            } else {
+                r[i + j] = tmp;
+            }
+        }
+    }
+}
+
+struct Impl {
+    const char *name;
+    void (*mul)(const limb *, size_t, const limb *, size_t, limb *);
+    bool quadratic;
+};
+
+const Impl IMPLS[] = {
+    {"legacy", legacyMul, true},
+    {"schoolbook", Util::BintKernel::mulSchoolbook, true},
+    {"karatsuba", Util::BintKernel::mulKaratsuba, false},
+    {"toom3", Util::BintKernel::mulToom3, false},
+    {"ntt", Util::BintKernel::mulNtt, false},
+    {"multiply", Util::BintKernel::multiply, false},
+};
+
+/**
+ * re-split little-endian limbs of fromDigits decimal digits into limbs of
+ * toDigits digits.
+ */
+std::vector<limb> rebase(const std::vector<limb> &a, size_t fromDigits, size_t toDigits) {
+    std::string digits;
+    for (size_t i = 0; i < a.size(); ++i) {
+        limb x = a[i];
+        for (size_t d = 0; d < fromDigits; ++d, x /= 10) digits += static_cast<char>('0' + x % 10);
+    }
+    std::vector<limb> out((digits.size() + toDigits - 1) / toDigits);
+    for (size_t i = digits.size(); i-- > 0;) out[i / toDigits] = out[i / toDigits] * 10 + (digits[i] - '0');
+    while (out.size() > 1 && out.back() == 0) out.pop_back();
+    return out;
+}
+
+std::vector<limb> randomLimbs(size_t count, std::mt19937 &rng) {
+    std::uniform_int_distribution<limb> dist(0, Util::BintKernel::BASE - 1);
+    std::vector<limb> v(count);
+    for (size_t i = 0; i < count; ++i) v[i] = dist(rng);
+    if (count) v.back() = std::max<limb>(v.back(), 1);
+    return v;
+}
+
+void runShape(bench::Runner &runner, const bench::Options &opts, const char *shape, size_t digits) {
+    std::mt19937 rng(static_cast<unsigned>(digits));
+    size_t n = std::max<size_t>(1, digits / DIGITS_PER_LIMB);
+    size_t m = shape[0] == 's' ? n : std::max<size_t>(1, n / 8);
+    std::vector<limb> a = randomLimbs(n, rng), b = randomLimbs(m, rng);
+    std::vector<limb> expected(n + m);
+    Util::BintKernel::multiply(a.data(), n, b.data(), m, expected.data());
+    std::vector<limb> trimmedExpected = rebase(expected, DIGITS_PER_LIMB, DIGITS_PER_LIMB);
+    for (const Impl &impl : IMPLS) {
+        bench::Case c = {"mul", impl.name, "Bint", shape, digits, 1};
+        if (impl.quadratic && digits > SCHOOLBOOK_CAP && !opts.uncapped) {
+            runner.skip(c, "quadratic, above the cap");
+            continue;
+        }
+        if (!runner.enabled(c)) continue;
+        bool legacy = impl.mul == legacyMul;
+        std::vector<limb> x = a, y = b;
+        if (legacy) {
+            x = rebase(a, DIGITS_PER_LIMB, LEGACY_DIGITS);
+            y = rebase(b, DIGITS_PER_LIMB, LEGACY_DIGITS);
+        }
+        std::vector<limb> r(x.size() + y.size());
+        runner.run(c, [&](bench::Stopwatch &sw) {
+            sw.start();
+            impl.mul(x.data(), x.size(), y.data(), y.size(), r.data());
+            sw.stop();
+            bench::doNotOptimize(r);
+        });
+        if (legacy) {
+            r = rebase(r, LEGACY_DIGITS, DIGITS_PER_LIMB);
+        } else {
+            r = rebase(r, DIGITS_PER_LIMB, DIGITS_PER_LIMB);
+        }
+        if (r != trimmedExpected) {
+            fprintf(stderr, "%s: wrong product\n", c.name().c_str());
+            mismatch = true;
+        }
+    }
+}
+
+void runAccumulate(bench::Runner &runner, const bench::Options &opts, size_t digits) {
+    bench::Case plus = {"accumulate", "operator+", "Bint", "sum", digits, ACCUMULATE_TERMS};
+    bench::Case plusAssign = {"accumulate", "operator+=", "Bint", "sum", digits, ACCUMULATE_TERMS};
+    if (digits > ACCUMULATE_CAP && !opts.uncapped) {
+        runner.skip(plus, "above the cap");
+        runner.skip(plusAssign, "above the cap");
+        return;
+    }
+    if (!runner.enabled(plus) && !runner.enabled(plusAssign)) return;
+    std::mt19937 rng(static_cast<unsigned>(digits));
+    std::uniform_int_distribution<int> digit(0, 9);
+    std::vector<Util::Bint> terms;
+    for (size_t i = 0; i < ACCUMULATE_TERMS; ++i) {
+        std::string s = i % 2 ? "-" : "";
+        s += static_cast<char>('1' + digit(rng) % 9);
+        for (size_t d = 1; d < digits; ++d) s += static_cast<char>('0' + digit(rng));
+        terms.push_back(Util::Bint(s));
+    }
+    Util::Bint byPlus, byPlusAssign;
+    runner.run(plus, [&](bench::Stopwatch &sw) {
+        Util::Bint sum;
+        sw.start();
+        for (const Util::Bint &x : terms) sum = sum + x;
+        sw.stop();
+        byPlus = sum;
+    });
+    runner.run(plusAssign, [&](bench::Stopwatch &sw) {
+        Util::Bint sum;
+        sw.start();
+        for (const Util::Bint &x : terms) sum += x;
+        sw.stop();
+        byPlusAssign = sum;
+    });
+    if (runner.enabled(plus) && runner.enabled(plusAssign) && byPlus != byPlusAssign) {
+        fprintf(stderr, "accumulate/%zu: operator+ and operator+= disagree\n", digits);
+        mismatch = true;
+    }
+}
+
+struct DivImpl {
+    const char *name;
+    void (*div)(const limb *, size_t, const limb *, size_t, limb *, limb *);
+    bool quadratic;
+};
+
+const DivImpl DIV_IMPLS[] = {
+    {"knuth", Util::BintKernel::divKnuth, true},
+    {"burnikel_ziegler", Util::BintKernel::divBurnikelZiegler, false},
+    {"divide", Util::BintKernel::divide, false},
+};
+
+// a == q * b + r with r < b
+bool checkDivision(const std::vector<limb> &a, const std::vector<limb> &b, const std::vector<limb> &q,
+                   const std::vector<limb> &r) {
+    using namespace Util::BintKernel;
+    std::vector<limb> back(q.size() + b.size() + 1);
+    multiply(q.data(), q.size(), b.data(), b.size(), back.data());
+    addInPlace(back.data(), back.size(), r.data(), r.size());
+    back.resize(trimmed(back.data(), back.size()));
+    return back == a && compareLimbs(r.data(), trimmed(r.data(), r.size()), b.data(), b.size()) < 0;
+}
+
+void runDiv(bench::Runner &runner, const bench::Options &opts, size_t digits) {
+    std::mt19937 rng(static_cast<unsigned>(digits));
+    size_t m = std::max<size_t>(1, digits / DIGITS_PER_LIMB);
+    std::vector<limb> a = randomLimbs(2 * m, rng), b = randomLimbs(m, rng);
+    for (const DivImpl &impl : DIV_IMPLS) {
+        bench::Case c = {"div", impl.name, "Bint", "2n_by_n", digits, 1};
+        if (impl.quadratic && digits > SCHOOLBOOK_CAP && !opts.uncapped) {
+            runner.skip(c, "quadratic, above the cap");
+            continue;
+        }
+        if (!runner.enabled(c)) continue;
+        std::vector<limb> q(a.size() - b.size() + 1), r(b.size());
+        runner.run(c, [&](bench::Stopwatch &sw) {
+            sw.start();
+            impl.div(a.data(), a.size(), b.data(), b.size(), q.data(), r.data());
+            sw.stop();
+            bench::doNotOptimize(q);
+        });
+        if (!checkDivision(a, b, q, r)) {
+            fprintf(stderr, "%s: wrong quotient or remainder\n", c.name().c_str());
+            mismatch = true;
+        }
+    }
+}
+
+void runPowMod(bench::Runner &runner, const bench::Options &opts, size_t digits) {
+    bench::Case montgomery = {"powmod", "montgomery", "Bint", "odd_modulus", digits, 1};
+    bench::Case divide = {"powmod", "divide", "Bint", "odd_modulus", digits, 1};
+    if (digits > POWMOD_CAP && !opts.uncapped) {
+        runner.skip(montgomery, "above the cap");
+        runner.skip(divide, "above the cap");
+        return;
+    }
+    if (!runner.enabled(montgomery) && !runner.enabled(divide)) return;
+    std::mt19937 rng(static_cast<unsigned>(digits));
+    size_t k = std::max<size_t>(1, digits / DIGITS_PER_LIMB);
+    std::vector<limb> m = randomLimbs(k, rng), x = randomLimbs(k, rng);
+    m[0] |= 1;
+    if (m[0] % 5 == 0) m[0] += 2;
+    x.back() = 0;
+    std::vector<unsigned> e(POWMOD_EXP_DIGITS * 10 / 3 / 32 + 1);
+    for (unsigned &w : e) w = static_cast<unsigned>(rng());
+    std::vector<limb> byMontgomery(k), byDivide(k);
+    runner.run(montgomery, [&](bench::Stopwatch &sw) {
+        sw.start();
+        Util::BintKernel::powModMontgomery(x.data(), m.data(), k, e.data(), e.size(), byMontgomery.data());
+        sw.stop();
+        bench::doNotOptimize(byMontgomery);
+    });
+    runner.run(divide, [&](bench::Stopwatch &sw) {
+        sw.start();
+        Util::BintKernel::powModDivide(x.data(), m.data(), k, e.data(), e.size(), byDivide.data());
+        sw.stop();
+        bench::doNotOptimize(byDivide);
+    });
+    if (runner.enabled(montgomery) && runner.enabled(divide) && byMontgomery != byDivide) {
+        fprintf(stderr, "powmod/%zu: montgomery and divide disagree\n", digits);
+        mismatch = true;
+    }
+}
+
+void runIo(bench::Runner &runner, size_t digits) {
+    size_t count = std::max<size_t>(1, IO_DIGITS / digits);
+    std::mt19937 rng(static_cast<unsigned>(digits));
+    std::vector<Util::Bint> values;
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+        std::string s = i % 2 ? "-" : "";
+        s += static_cast<char>('1' + rng() % 9);
+        for (size_t d = 1; d < digits; ++d) s += static_cast<char>('0' + rng() % 10);
+        values.push_back(Util::Bint(s));
+        text += s + ' ';
+    }
+    bench::Case print = {"io", "operator<<", "Bint", "print", digits, count};
+    runner.run(print, [&](bench::Stopwatch &sw) {
+        std::ostringstream out;
+        sw.start();
+        for (const Util::Bint &x : values) out << x << ' ';
+        sw.stop();
+        if (out.str() != text) mismatch = true;
+    });
+    bench::Case toChars = {"io", "toChars", "Bint", "print", digits, count};
+    runner.run(toChars, [&](bench::Stopwatch &sw) {
+        std::vector<char> buffer(text.size() + count);
+        sw.start();
+        char *out = buffer.data();
+        for (const Util::Bint &x : values) {
+            out = x.toChars(out);
+            *out++ = ' ';
+        }
+        sw.stop();
+        if (std::string(buffer.data(), out) != text) mismatch = true;
+    });
+    bench::Case stringCtor = {"io", "string_ctor", "Bint", "parse", digits, count};
+    runner.run(stringCtor, [&](bench::Stopwatch &sw) {
+        std::istringstream in(text);
+        std::vector<Util::Bint> parsed(count);
+        sw.start();
+        std::string s;
+        for (Util::Bint &x : parsed) {
+            in >> s;
+            x = Util::Bint(s);
+        }
+        sw.stop();
+        if (parsed != values) mismatch = true;
+    });
+    bench::Case extract = {"io", "operator>>", "Bint", "parse", digits, count};
+    runner.run(extract, [&](bench::Stopwatch &sw) {
+        std::istringstream in(text);
+        std::vector<Util::Bint> parsed(count);
+        sw.start();
+        for (Util::Bint &x : parsed) in >> x;
+        sw.stop();
+        if (parsed != values) mismatch = true;
+    });
+    if (mismatch) fprintf(stderr, "io/%zu: printed or parsed values differ\n", digits);
+}
+
+void runCarry(bench::Runner &runner, size_t digits) {
+    using namespace Util::BintKernel;
+    std::mt19937 rng(static_cast<unsigned>(digits));
+    size_t n = std::max<size_t>(1, digits / DIGITS_PER_LIMB);
+    std::vector<limb> a = randomLimbs(n, rng), b = randomLimbs(n, rng), copy = a;
+    std::vector<limb> expectSum(n), expectDifference(n);
+    addCarry(a.data(), b.data(), expectSum.data(), n, 0, Scalar);
+    subBorrow(a.data(), b.data(), expectDifference.data(), n, 0, Scalar);
+    for (SimdLevel level : {Scalar, SSE42, AVX2}) {
+        bench::Case add = {"carry", simdLevelName(level), "Bint", "add", digits, n};
+        bench::Case sub = {"carry", simdLevelName(level), "Bint", "sub", digits, n};
+        bench::Case compare = {"carry", simdLevelName(level), "Bint", "compare", digits, n};
+        if (level > simdDetected()) {
+            runner.skip(add, "not supported by this CPU");
+            runner.skip(sub, "not supported by this CPU");
+            runner.skip(compare, "not supported by this CPU");
+            continue;
+        }
+        std::vector<limb> r(n);
+        runner.run(add, [&](bench::Stopwatch &sw) {
+            sw.start();
+            limb carry = addCarry(a.data(), b.data(), r.data(), n, 0, level);
+            sw.stop();
+            bench::doNotOptimize(carry);
+        });
+        if (runner.enabled(add) && r != expectSum) mismatch = true;
+        runner.run(sub, [&](bench::Stopwatch &sw) {
+            sw.start();
+            limb borrow = subBorrow(a.data(), b.data(), r.data(), n, 0, level);
+            sw.stop();
+            bench::doNotOptimize(borrow);
+        });
+        if (runner.enabled(sub) && r != expectDifference) mismatch = true;
+        runner.run(compare, [&](bench::Stopwatch &sw) {
+            sw.start();
+            int sign = compareLimbs(a.data(), n, copy.data(), n, level);
+            sw.stop();
+            bench::doNotOptimize(sign);
+            if (sign != 0) mismatch = true;
+        });
+    }
+    if (mismatch) fprintf(stderr, "carry/%zu: a SIMD level disagrees with scalar\n", digits);
+}
+
+void runLiteral(bench::Runner &runner) {
+    using namespace Util::literals;
+    const char *const texts[] = {
+        "12157665459056928801",
+        "717897987691852588770249",
+        "42391158275216203514294433201",
+        "2503155504993241601315571986085849",
+        "147808829414345923316083210206383297601",
+        "8727963568087712425891397479476727340041449",
+        "515377520732011331036461129765621272702107522001",
+        "30432527221704537086371993251530170531786747066637049"
+    };
+    const size_t count = sizeof(texts) / sizeof(texts[0]);
+    bench::Case fromString = {"literal", "string_ctor", "Bint", "seed", 0, LITERAL_COPIES * count};
+    bench::Case fromLiteral = {"literal", "_bint", "Bint", "seed", 0, LITERAL_COPIES * count};
+    std::vector<Util::Bint> byString, byLiteral;
+    runner.run(fromString, [&](bench::Stopwatch &sw) {
+        std::vector<Util::Bint> seeded;
+        seeded.reserve(LITERAL_COPIES * count);
+        sw.start();
+        for (size_t copy = 0; copy < LITERAL_COPIES; ++copy) {
+            for (const char *text : texts) seeded.push_back(Util::Bint(std::string(text)));
+        }
+        sw.stop();
+        byString.swap(seeded);
+    });
+    runner.run(fromLiteral, [&](bench::Stopwatch &sw) {
+        std::vector<Util::Bint> seeded;
+        seeded.reserve(LITERAL_COPIES * count);
+        sw.start();
+        for (size_t copy = 0; copy < LITERAL_COPIES; ++copy) {
+            seeded.insert(seeded.end(), {
+                Util::Bint(12157665459056928801_bint),
+                Util::Bint(717897987691852588770249_bint),
+                Util::Bint(42391158275216203514294433201_bint),
+                Util::Bint(2503155504993241601315571986085849_bint),
+                Util::Bint(147808829414345923316083210206383297601_bint),
+                Util::Bint(8727963568087712425891397479476727340041449_bint),
+                Util::Bint(515377520732011331036461129765621272702107522001_bint),
+                Util::Bint(30432527221704537086371993251530170531786747066637049_bint)
+            });
+        }
+        sw.stop();
+        byLiteral.swap(seeded);
+    });
+    if (runner.enabled(fromString) && runner.enabled(fromLiteral) && byString != byLiteral) {
+        fprintf(stderr, "literal: string and _bint constants differ\n");
+        mismatch = true;
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    bench::Options opts = bench::parseOptions(argc, argv, {100, 1000, 10000, 100000, 1000000});
+    bench::Runner runner(opts);
+    std::unique_ptr<bench::PerfCounters> perfProbe;
+    if (opts.perf) {
+        perfProbe.reset(new bench::PerfCounters());
+        runner.addProbe(perfProbe.get());
+    }
+    for (size_t digits : opts.sizes) {
+        runShape(runner, opts, "square", digits);
+        runShape(runner, opts, "unbalanced", digits);
+        runAccumulate(runner, opts, digits);
+        runDiv(runner, opts, digits);
+        runPowMod(runner, opts, digits);
+        runIo(runner, digits);
+        runCarry(runner, digits);
+    }
+    runLiteral(runner);
+    if (!runner.report()) return 1;
+    return mismatch ? 1 : 0;
+}
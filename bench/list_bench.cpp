@@ -0,0 +1,366 @@
+/**
+ * list_bench: micro-benchmarks comparing sjtu::list with std::list.
+ *
+ * Every operation runs over int, Integer, Bint, Diamond::Matrix<double> and
+ * the DynamicType used by data/two at sizes 1e3 .. 1e7. Heavy element types
+ * are capped to a size that fits in memory (see Element<T>::cap); pass
+ * --uncapped to lift the caps. Operations that need operator< are skipped
+ * for types that do not provide it.
+ *
+ * list_bench_alloc is the same driver linked with alloc_counter.cpp: it adds
+ * allocs / alloc_bytes / peak_live_bytes per case to the report and exits
+ * non-zero when merge, reverse or unique allocate.
+ *
+ * --perf adds hardware counters (cycles, instructions, ipc, L1D / LLC and
+ * branch misses) per case where perf_event_open allows it.
+ */
+
+#include "class-integer.hpp"
+#include "class-matrix.hpp"
+#include "class-bint.hpp"
+#include "class-dynamic.hpp"
+#include "list.hpp"
+#include "bench.hpp"
+#include "perf_counters.hpp"
+
+#include <list>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <utility>
+
+#ifdef LIST_BENCH_ALLOC_COUNTER
+#include "alloc_counter.hpp"
+#define BENCH_NO_ALLOC(name) alloc::ExpectNoAlloc noAlloc(name)
+#else
+#define BENCH_NO_ALLOC(name)
+#endif
+
+namespace {
+
+#ifdef LIST_BENCH_ALLOC_COUNTER
+class AllocProbe : public bench::Probe {
+private:
+    alloc::Stats sum;
+
+public:
+    void reset() override {
+        sum = alloc::Stats();
+    }
+
+    void start() override {
+        alloc::begin("timed");
+    }
+
+    void stop() override {
+        alloc::Stats s = alloc::end();
+        sum.allocations += s.allocations;
+        sum.bytes += s.bytes;
+        sum.peakLive = std::max(sum.peakLive, s.peakLive);
+    }
+
+    void collect(bench::Metrics &metrics) override {
+        metrics.push_back(std::make_pair("allocs", static_cast<double>(sum.allocations)));
+        metrics.push_back(std::make_pair("alloc_bytes", static_cast<double>(sum.bytes)));
+        metrics.push_back(std::make_pair("peak_live_bytes", static_cast<double>(sum.peakLive)));
+    }
+};
+#endif
+
+int liveDynamic = 0;
+
+template<typename T>
+struct Element;
+
+template<>
+struct Element<int> {
+    static const char *name() { return "int"; }
+    static int make(int key) { return key; }
+    static const size_t cap = 10000000;
+};
+
+template<>
+struct Element<Integer> {
+    static const char *name() { return "Integer"; }
+    static Integer make(int key) { return Integer(key); }
+    static const size_t cap = 10000000;
+};
+
+template<>
+struct Element<Util::Bint> {
+    static const char *name() { return "Bint"; }
+    static Util::Bint make(int key) { return Util::Bint(key); }
+    static const size_t cap = 1000000;
+};
+
+template<>
+struct Element<Diamond::Matrix<double>> {
+    static const char *name() { return "Matrix<double>"; }
+    static Diamond::Matrix<double> make(int key) { return Diamond::Matrix<double>(2, 2, key); }
+    static const size_t cap = 1000000;
+};
+
+template<>
+struct Element<DynamicType> {
+    static const char *name() { return "DynamicType"; }
+    static DynamicType make(int key) { return DynamicType(&liveDynamic, key); }
+    static const size_t cap = 1000000;
+};
+
+template<typename T, typename = void>
+struct HasLess : std::false_type {};
+
+template<typename T>
+struct HasLess<T, decltype(void(std::declval<const T &>() < std::declval<const T &>()))> : std::true_type {};
+
+/**
+ * inputs shared by every case of one (type, size) pair.
+ */
+template<typename T>
+struct Inputs {
+    std::vector<T> shuffled;    // random keys
+    std::vector<T> ascending;   // sorted keys, used for merge
+    std::vector<T> duplicated;  // every key repeated twice in a row, used for unique
+    std::vector<size_t> insertAt;
+    std::vector<size_t> eraseAt;
+};
+
+template<typename T>
+Inputs<T> makeInputs(size_t n, std::mt19937 &rng) {
+    Inputs<T> in;
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = static_cast<int>(rng() % (4 * n + 1));
+    }
+    in.shuffled.reserve(n);
+    in.duplicated.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        in.shuffled.push_back(Element<T>::make(keys[i]));
+        in.duplicated.push_back(Element<T>::make(keys[i / 2]));
+    }
+    std::sort(keys.begin(), keys.end());
+    in.ascending.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        in.ascending.push_back(Element<T>::make(keys[i]));
+    }
+
+    // positions are drawn so that they stay valid while the list grows / shrinks;
+    // every access walks O(n) nodes, so large lists get fewer of them
+    size_t k = std::min<size_t>(std::min<size_t>(n / 2, 1000), std::max<size_t>(10, 100000000 / n));
+    for (size_t i = 0; i < k; ++i) {
+        in.insertAt.push_back(rng() % (n + 1));
+        in.eraseAt.push_back(rng() % (n - k));
+    }
+    return in;
+}
+
+template<typename List, typename T>
+void fill(List &l, const std::vector<T> &values) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        l.push_back(values[i]);
+    }
+}
+
+template<typename List>
+typename List::iterator walk(List &l, size_t steps) {
+    typename List::iterator it = l.begin();
+    while (steps--) ++it;
+    return it;
+}
+
+template<typename List, typename T>
+void runOrdered(bench::Runner &runner, bench::Case c, const Inputs<T> &in, std::true_type) {
+    size_t n = in.shuffled.size();
+
+    c.op = "sort";
+    c.ops = n;
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.shuffled);
+        sw.start();
+        l.sort();
+        sw.stop();
+    });
+
+    c.op = "merge";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List a, b;
+        for (size_t i = 0; i < n; ++i) {
+            (i % 2 ? b : a).push_back(in.ascending[i]);
+        }
+        sw.start();
+        {
+            BENCH_NO_ALLOC("merge");
+            a.merge(b);
+        }
+        sw.stop();
+    });
+}
+
+template<typename List, typename T>
+void runOrdered(bench::Runner &, bench::Case, const Inputs<T> &, std::false_type) {}
+
+template<typename List, typename T>
+void runSuite(bench::Runner &runner, const char *impl, const Inputs<T> &in) {
+    size_t n = in.shuffled.size();
+    bench::Case c;
+    c.suite = "list";
+    c.impl = impl;
+    c.type = Element<T>::name();
+    c.n = n;
+    c.ops = n;
+
+    c.op = "push_back";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        sw.start();
+        fill(l, in.shuffled);
+        sw.stop();
+    });
+
+    c.op = "push_front";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        sw.start();
+        for (size_t i = 0; i < n; ++i) l.push_front(in.shuffled[i]);
+        sw.stop();
+    });
+
+    c.op = "pop_back";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.shuffled);
+        sw.start();
+        while (!l.empty()) l.pop_back();
+        sw.stop();
+    });
+
+    c.op = "pop_front";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.shuffled);
+        sw.start();
+        while (!l.empty()) l.pop_front();
+        sw.stop();
+    });
+
+    c.op = "iterate";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.shuffled);
+        sw.start();
+        for (typename List::iterator it = l.begin(); it != l.end(); ++it) {
+            bench::doNotOptimize(*it);
+        }
+        sw.stop();
+    });
+
+    c.op = "copy";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.shuffled);
+        sw.start();
+        {
+            List copy(l);
+            bench::doNotOptimize(copy);
+            sw.stop();
+        }
+    });
+
+    c.op = "reverse";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.shuffled);
+        sw.start();
+        {
+            BENCH_NO_ALLOC("reverse");
+            l.reverse();
+        }
+        sw.stop();
+    });
+
+    c.op = "unique";
+    runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.duplicated);
+        sw.start();
+        {
+            BENCH_NO_ALLOC("unique");
+            l.unique();
+        }
+        sw.stop();
+    });
+
+    // random positions cost a walk from begin(); that walk is part of the operation
+    c.op = "insert_random";
+    c.ops = in.insertAt.size();
+    if (c.ops) runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.shuffled);
+        sw.start();
+        for (size_t i = 0; i < in.insertAt.size(); ++i) {
+            l.insert(walk(l, in.insertAt[i]), in.shuffled[i]);
+        }
+        sw.stop();
+    });
+
+    c.op = "erase_random";
+    c.ops = in.eraseAt.size();
+    if (c.ops) runner.run(c, [&](bench::Stopwatch &sw) {
+        List l;
+        fill(l, in.shuffled);
+        sw.start();
+        for (size_t i = 0; i < in.eraseAt.size(); ++i) {
+            l.erase(walk(l, in.eraseAt[i]));
+        }
+        sw.stop();
+    });
+
+    runOrdered<List>(runner, c, in, HasLess<T>());
+}
+
+template<typename T>
+void runType(bench::Runner &runner) {
+    std::mt19937 rng(20220201);
+    const bench::Options &opts = runner.options();
+    for (size_t i = 0; i < opts.sizes.size(); ++i) {
+        size_t n = opts.sizes[i];
+        if (n < 2) continue;
+        if (!opts.uncapped && n > Element<T>::cap) {
+            fprintf(stderr, "skipping %s at n=%zu (cap %zu, use --uncapped)\n", Element<T>::name(), n, Element<T>::cap);
+            continue;
+        }
+        Inputs<T> in = makeInputs<T>(n, rng);
+        runSuite<sjtu::list<T>>(runner, "sjtu::list", in);
+        runSuite<std::list<T>>(runner, "std::list", in);
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    bench::Options opts = bench::parseOptions(argc, argv, {1000, 10000, 100000, 1000000, 10000000});
+    bench::Runner runner(opts);
+#ifdef LIST_BENCH_ALLOC_COUNTER
+    AllocProbe allocProbe;
+    runner.addProbe(&allocProbe);
+#endif
+    std::unique_ptr<bench::PerfCounters> perfProbe;
+    if (opts.perf) {
+        perfProbe.reset(new bench::PerfCounters());
+        runner.addProbe(perfProbe.get());
+    }
+    runType<int>(runner);
+    runType<Integer>(runner);
+    runType<Util::Bint>(runner);
+    runType<Diamond::Matrix<double>>(runner);
+    runType<DynamicType>(runner);
+    if (!runner.report()) return 1;
+#ifdef LIST_BENCH_ALLOC_COUNTER
+    if (alloc::violations()) {
+        fprintf(stderr, "%zu operation(s) allocated although they must not\n", alloc::violations());
+        return 1;
+    }
+#endif
+    return 0;
+}
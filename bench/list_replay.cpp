@@ -0,0 +1,286 @@
+/**
+ * list_replay: replay a recorded operation trace against list implementations.
+ *
+ *   list_replay TRACE [--impl NAME] [--histogram]
+ *   list_replay --generate TRACE [--ops N] [--seed S]
+ *
+ * Every implementation replays the whole trace on long long values rebuilt
+ * from the recorded keys. Each operation is timed; the report lists count,
+ * mean and log2-bucketed percentiles per operation type (--histogram prints
+ * the buckets themselves). Insert / erase time includes walking to the
+ * recorded index from the nearer end. At the end all implementations must
+ * hold the same contents, and for order-preserving traces they must also
+ * match the hash recorded in the trace; otherwise the exit status is 1.
+ *
+ * --generate records a synthetic mixed workload through optrace::Recorder,
+ * which is handy for trying the tool and for testing it.
+ */
+
+#include "op_trace.hpp"
+#include "bench.hpp"
+
+#include <chrono>
+#include <list>
+#include <random>
+
+namespace {
+
+const int BUCKETS = 48;
+
+struct Histogram {
+    uint64_t buckets[BUCKETS] = {};
+    uint64_t count = 0;
+    double totalNs = 0;
+    double maxNs = 0;
+
+    void add(double ns) {
+        int b = 0;
+        while (b + 1 < BUCKETS && (1ULL << (b + 1)) <= ns) ++b;
+        ++buckets[b];
+        ++count;
+        totalNs += ns;
+        if (ns > maxNs) maxNs = ns;
+    }
+
+    /**
+     * upper bound (2^(b+1) ns) of the bucket holding the p-quantile.
+     */
+    double quantile(double p) const {
+        uint64_t rank = static_cast<uint64_t>(p * count + 0.999999);
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += buckets[b];
+            if (seen >= rank && seen) return static_cast<double>(1ULL << (b + 1));
+        }
+        return maxNs;
+    }
+};
+
+struct Outcome {
+    std::string impl;
+    Histogram perOp[optrace::OpCount];
+    uint64_t size = 0;
+    uint64_t hash = optrace::HASH_SEED;
+    uint64_t skipped = 0;  // operations that were invalid at that point (e.g. pop on empty)
+};
+
+template<typename List>
+typename List::iterator seek(List &l, size_t index, size_t size) {
+    typename List::iterator it;
+    if (index <= size / 2) {
+        it = l.begin();
+        while (index--) ++it;
+    } else {
+        it = l.end();
+        for (size_t i = size; i > index; --i) --it;
+    }
+    return it;
+}
+
+template<typename List>
+Outcome replay(const char *impl, const optrace::Trace &trace) {
+    typedef std::chrono::steady_clock clock;
+    Outcome out;
+    out.impl = impl;
+    List l;
+    size_t size = 0;
+    for (size_t i = 0; i < trace.records.size(); ++i) {
+        const optrace::Record &r = trace.records[i];
+        long long value = optrace::keyValue(r.value);
+        bool empty = size == 0;
+        if (r.op == optrace::End ||
+            (empty && (r.op == optrace::PopBack || r.op == optrace::PopFront || r.op == optrace::Front ||
+                       r.op == optrace::Back || r.op == optrace::Erase)) ||
+            (r.op == optrace::Insert && r.position > size) || (r.op == optrace::Erase && r.position >= size)) {
+            if (r.op != optrace::End) ++out.skipped;
+            continue;
+        }
+        List other;
+        if (r.op == optrace::Merge) {
+            for (size_t k = 0; k < r.keys.size(); ++k) other.push_back(optrace::keyValue(r.keys[k]));
+        }
+        clock::time_point begin = clock::now();
+        switch (r.op) {
+            case optrace::PushBack: l.push_back(value); ++size; break;
+            case optrace::PushFront: l.push_front(value); ++size; break;
+            case optrace::PopBack: l.pop_back(); --size; break;
+            case optrace::PopFront: l.pop_front(); --size; break;
+            case optrace::Insert: l.insert(seek(l, r.position, size), value); ++size; break;
+            case optrace::Erase: l.erase(seek(l, r.position, size)); --size; break;
+            case optrace::Sort: l.sort(); break;
+            case optrace::Merge: l.merge(other); size += r.keys.size(); break;
+            case optrace::Reverse: l.reverse(); break;
+            case optrace::Unique: l.unique(); size = l.size(); break;
+            case optrace::Clear: l.clear(); size = 0; break;
+            case optrace::Copy: {
+                List copy(l);
+                bench::doNotOptimize(copy);
+                break;
+            }
+            case optrace::Front: bench::doNotOptimize(l.front()); break;
+            case optrace::Back: bench::doNotOptimize(l.back()); break;
+            default: break;
+        }
+        clock::time_point end = clock::now();
+        out.perOp[r.op].add(std::chrono::duration<double, std::nano>(end - begin).count());
+    }
+    out.size = l.size();
+    for (typename List::iterator it = l.begin(); it != l.end(); ++it) {
+        out.hash = optrace::hashKeys(out.hash, optrace::valueKey(*it));
+    }
+    return out;
+}
+
+void print(const Outcome &o, bool histogram) {
+    printf("%s\n", o.impl.c_str());
+    printf("  %-12s %10s %12s %10s %10s %10s %12s\n", "op", "count", "mean ns", "p50 <=", "p90 <=", "p99 <=", "max ns");
+    for (int op = 0; op < optrace::OpCount; ++op) {
+        const Histogram &h = o.perOp[op];
+        if (!h.count) continue;
+        printf("  %-12s %10llu %12.1f %10.0f %10.0f %10.0f %12.0f\n", optrace::opName(static_cast<optrace::Op>(op)),
+               static_cast<unsigned long long>(h.count), h.totalNs / h.count, h.quantile(0.5), h.quantile(0.9),
+               h.quantile(0.99), h.maxNs);
+        if (histogram) {
+            for (int b = 0; b < BUCKETS; ++b) {
+                if (h.buckets[b]) {
+                    printf("      [%llu, %llu) ns: %llu\n", 1ULL << b, 1ULL << (b + 1),
+                           static_cast<unsigned long long>(h.buckets[b]));
+                }
+            }
+        }
+    }
+    if (o.skipped) printf("  %llu operation(s) skipped as invalid\n", static_cast<unsigned long long>(o.skipped));
+}
+
+/**
+ * record a mixed synthetic workload: mostly pushes and positional
+ * inserts / erases, with occasional whole-list operations.
+ */
+bool generate(const std::string &path, size_t ops, unsigned seed) {
+    std::mt19937 rng(seed);
+    optrace::Recorder<int> rec;
+    for (size_t i = 0; i < ops; ++i) {
+        unsigned r = rng() % 100;
+        int value = static_cast<int>(rng() % 100000) - 50000;
+        if (r < 30) {
+            rec.push_back(value);
+        } else if (r < 45) {
+            rec.push_front(value);
+        } else if (r < 60 && !rec.empty()) {
+            size_t at = rng() % rec.size();
+            typename optrace::Recorder<int>::iterator it = rec.begin();
+            while (at--) ++it;
+            rec.insert(it, value);
+        } else if (r < 72 && !rec.empty()) {
+            size_t at = rng() % rec.size();
+            typename optrace::Recorder<int>::iterator it = rec.begin();
+            while (at--) ++it;
+            rec.erase(it);
+        } else if (r < 80 && !rec.empty()) {
+            rng() % 2 ? rec.pop_back() : rec.pop_front();
+        } else if (r < 88 && !rec.empty()) {
+            rng() % 2 ? rec.front() : rec.back();
+        } else if (r < 91) {
+            rec.sort();
+        } else if (r < 93) {
+            rec.sort();
+            sjtu::list<int> other;
+            for (int k = static_cast<int>(rng() % 32); k > 0; --k) other.push_back(static_cast<int>(rng() % 100000) - 50000);
+            other.sort();
+            rec.merge(other);
+        } else if (r < 95) {
+            rec.reverse();
+        } else if (r < 97) {
+            rec.unique();
+        } else if (r < 99) {
+            rec.copy();
+        } else {
+            rec.clear();
+        }
+    }
+    return rec.save(path);
+}
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s TRACE [--impl sjtu::list|std::list] [--histogram]\n"
+            "       %s --generate TRACE [--ops N] [--seed S]\n",
+            prog, prog);
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string path, impl;
+    bool histogram = false, gen = false;
+    size_t ops = 100000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--generate" && hasValue) {
+            gen = true;
+            path = argv[++i];
+        } else if (arg == "--ops" && hasValue) {
+            ops = static_cast<size_t>(atof(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            seed = static_cast<unsigned>(atol(argv[++i]));
+        } else if (arg == "--impl" && hasValue) {
+            impl = argv[++i];
+        } else if (arg == "--histogram") {
+            histogram = true;
+        } else if (path.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (gen) {
+        if (!generate(path, ops, seed)) {
+            fprintf(stderr, "cannot write %s\n", path.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    optrace::Trace trace;
+    std::string error;
+    if (!optrace::load(path, trace, error)) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+        return 1;
+    }
+    printf("%s: %zu operations\n", path.c_str(), trace.records.size());
+
+    std::vector<Outcome> outcomes;
+    if (impl.empty() || impl == "sjtu::list") outcomes.push_back(replay<sjtu::list<long long>>("sjtu::list", trace));
+    if (impl.empty() || impl == "std::list") outcomes.push_back(replay<std::list<long long>>("std::list", trace));
+    if (outcomes.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    bool okay = true;
+    for (size_t i = 0; i < outcomes.size(); ++i) {
+        print(outcomes[i], histogram);
+        if (outcomes[i].size != outcomes[0].size || outcomes[i].hash != outcomes[0].hash) {
+            printf("  final contents differ from %s\n", outcomes[0].impl.c_str());
+            okay = false;
+        }
+    }
+    if (!trace.records.empty() && trace.records.back().op == optrace::End && (trace.flags & optrace::ORDER_PRESERVING)) {
+        const optrace::Record &end = trace.records.back();
+        if (outcomes[0].size != end.position || outcomes[0].hash != end.value) {
+            printf("final contents differ from the recording (size %llu vs %llu)\n",
+                   static_cast<unsigned long long>(outcomes[0].size), static_cast<unsigned long long>(end.position));
+            okay = false;
+        } else {
+            printf("final contents match the recording\n");
+        }
+    }
+    return okay ? 0 : 1;
+}
@@ -0,0 +1,334 @@
+#ifndef SJTU_OP_TRACE_HPP
+#define SJTU_OP_TRACE_HPP
+
+#include "list.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Compact binary traces of list operations, written by optrace::Recorder
+ * and read back by list_replay.
+ *
+ * File layout: the magic "LTRC", a version byte and a flags byte, then one
+ * record per operation: an op byte followed by LEB128 varints. Positions are
+ * element indices counted from begin(). Values are stored as a 64-bit key
+ * (see valueKey); merge stores the keys of the other list. The last record
+ * (End) holds the final size and an FNV-1a hash over the final keys, which
+ * lets a replay check that it ended with the same contents.
+ */
+namespace optrace {
+
+enum Op : uint8_t {
+    PushBack, PushFront, PopBack, PopFront, Insert, Erase,
+    Sort, Merge, Reverse, Unique, Clear, Copy, Front, Back,
+    End, OpCount
+};
+
+inline const char *opName(Op op) {
+    static const char *names[OpCount] = {
+        "push_back", "push_front", "pop_back", "pop_front", "insert", "erase",
+        "sort", "merge", "reverse", "unique", "clear", "copy", "front", "back", "end"
+    };
+    return op < OpCount ? names[op] : "?";
+}
+
+inline bool hasPosition(Op op) {
+    return op == Insert || op == Erase;
+}
+
+inline bool hasValue(Op op) {
+    return op == PushBack || op == PushFront || op == Insert;
+}
+
+const uint8_t VERSION = 1;
+// the keys order like the recorded values, so sort/merge replay faithfully
+const uint8_t ORDER_PRESERVING = 1;
+
+/**
+ * map a value to its 64-bit trace key. Signed integers are offset so that
+ * unsigned key order equals value order. Other element types provide their
+ * own valueKey overload (found by ADL) and usually are not order preserving.
+ */
+template<typename T>
+inline uint64_t valueKey(const T &value, typename std::enable_if<std::is_integral<T>::value>::type * = nullptr) {
+    return static_cast<uint64_t>(static_cast<int64_t>(value)) ^ (std::is_signed<T>::value ? 1ULL << 63 : 0);
+}
+
+template<typename T>
+struct KeyTraits {
+    static const bool orderPreserving = std::is_integral<T>::value;
+};
+
+/**
+ * inverse of valueKey for the signed 64-bit values list_replay stores.
+ */
+inline long long keyValue(uint64_t key) {
+    return static_cast<long long>(key ^ (1ULL << 63));
+}
+
+inline uint64_t hashKeys(uint64_t hash, uint64_t key) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (key >> (8 * i)) & 0xff;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+const uint64_t HASH_SEED = 14695981039346656037ULL;
+
+struct Record {
+    Op op;
+    uint64_t position;
+    uint64_t value;
+    std::vector<uint64_t> keys;  // Merge: the other list; End: unused
+};
+
+struct Trace {
+    uint8_t flags;
+    std::vector<Record> records;
+};
+
+class Writer {
+private:
+    std::vector<unsigned char> buffer;
+
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            buffer.push_back(static_cast<unsigned char>(v | 0x80));
+            v >>= 7;
+        }
+        buffer.push_back(static_cast<unsigned char>(v));
+    }
+
+public:
+    explicit Writer(uint8_t flags) {
+        buffer.push_back('L');
+        buffer.push_back('T');
+        buffer.push_back('R');
+        buffer.push_back('C');
+        buffer.push_back(VERSION);
+        buffer.push_back(flags);
+    }
+
+    void write(Op op, uint64_t position = 0, uint64_t value = 0) {
+        buffer.push_back(op);
+        if (hasPosition(op)) varint(position);
+        if (hasValue(op)) varint(value);
+    }
+
+    void writeMerge(const std::vector<uint64_t> &keys) {
+        buffer.push_back(Merge);
+        varint(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) varint(keys[i]);
+    }
+
+    void writeEnd(uint64_t size, uint64_t hash) {
+        buffer.push_back(End);
+        varint(size);
+        varint(hash);
+    }
+
+    size_t bytes() const {
+        return buffer.size();
+    }
+
+    bool save(const std::string &path) const {
+        FILE *f = fopen(path.c_str(), "wb");
+        if (f == nullptr) return false;
+        bool ok = fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+        return fclose(f) == 0 && ok;
+    }
+};
+
+/**
+ * read a trace; returns false on I/O errors or malformed input.
+ */
+inline bool load(const std::string &path, Trace &trace, std::string &error) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<unsigned char> data;
+    unsigned char chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + got);
+    fclose(f);
+
+    if (data.size() < 6 || data[0] != 'L' || data[1] != 'T' || data[2] != 'R' || data[3] != 'C') {
+        error = "not a list trace";
+        return false;
+    }
+    if (data[4] != VERSION) {
+        error = "unsupported trace version";
+        return false;
+    }
+    trace.flags = data[5];
+    trace.records.clear();
+    size_t at = 6;
+    bool truncated = false;
+    auto varint = [&]() -> uint64_t {
+        uint64_t v = 0;
+        for (int shift = 0; at < data.size() && shift < 64; shift += 7) {
+            unsigned char b = data[at++];
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        truncated = true;
+        return v;
+    };
+    while (at < data.size() && !truncated) {
+        Record r;
+        r.op = static_cast<Op>(data[at++]);
+        r.position = r.value = 0;
+        if (r.op >= OpCount) {
+            error = "unknown operation in trace";
+            return false;
+        }
+        if (r.op == Merge) {
+            uint64_t n = varint();
+            for (uint64_t i = 0; i < n && !truncated; ++i) r.keys.push_back(varint());
+        } else if (r.op == End) {
+            r.position = varint();
+            r.value = varint();
+        } else {
+            if (hasPosition(r.op)) r.position = varint();
+            if (hasValue(r.op)) r.value = varint();
+        }
+        trace.records.push_back(r);
+    }
+    if (truncated) {
+        error = "truncated trace";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * an sjtu::list that logs every operation into a trace. Positions are found
+ * by walking from begin(), so recording costs O(n) per insert / erase.
+ */
+template<typename T>
+class Recorder {
+public:
+    typedef typename sjtu::list<T>::iterator iterator;
+    typedef typename sjtu::list<T>::const_iterator const_iterator;
+
+private:
+    sjtu::list<T> items;
+    Writer writer;
+
+    uint64_t indexOf(const_iterator pos) const {
+        uint64_t index = 0;
+        for (const_iterator it = items.cbegin(); it != pos && it != items.cend(); ++it) ++index;
+        return index;
+    }
+
+public:
+    Recorder() : writer(KeyTraits<T>::orderPreserving ? ORDER_PRESERVING : 0) {}
+
+    sjtu::list<T> &list() {
+        return items;
+    }
+
+    iterator begin() { return items.begin(); }
+    iterator end() { return items.end(); }
+    const_iterator cbegin() const { return items.cbegin(); }
+    const_iterator cend() const { return items.cend(); }
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+
+    T &front() {
+        writer.write(Front);
+        return items.front();
+    }
+
+    T &back() {
+        writer.write(Back);
+        return items.back();
+    }
+
+    void push_back(const T &value) {
+        writer.write(PushBack, 0, valueKey(value));
+        items.push_back(value);
+    }
+
+    void push_front(const T &value) {
+        writer.write(PushFront, 0, valueKey(value));
+        items.push_front(value);
+    }
+
+    void pop_back() {
+        writer.write(PopBack);
+        items.pop_back();
+    }
+
+    void pop_front() {
+        writer.write(PopFront);
+        items.pop_front();
+    }
+
+    iterator insert(iterator pos, const T &value) {
+        writer.write(Insert, indexOf(pos), valueKey(value));
+        return items.insert(pos, value);
+    }
+
+    iterator erase(iterator pos) {
+        writer.write(Erase, indexOf(pos));
+        return items.erase(pos);
+    }
+
+    void clear() {
+        writer.write(Clear);
+        items.clear();
+    }
+
+    /**
+     * copies are replayed as a copy constructed and immediately destroyed.
+     */
+    sjtu::list<T> copy() {
+        writer.write(Copy);
+        return sjtu::list<T>(items);
+    }
+
+    void sort() {
+        writer.write(Sort);
+        items.sort();
+    }
+
+    void merge(sjtu::list<T> &other) {
+        std::vector<uint64_t> keys;
+        for (const_iterator it = other.cbegin(); it != other.cend(); ++it) keys.push_back(valueKey(*it));
+        writer.writeMerge(keys);
+        items.merge(other);
+    }
+
+    void reverse() {
+        writer.write(Reverse);
+        items.reverse();
+    }
+
+    void unique() {
+        writer.write(Unique);
+        items.unique();
+    }
+
+    /**
+     * append the End record and write the trace to path.
+     */
+    bool save(const std::string &path) {
+        uint64_t hash = HASH_SEED;
+        for (const_iterator it = items.cbegin(); it != items.cend(); ++it) hash = hashKeys(hash, valueKey(*it));
+        Writer finished = writer;
+        finished.writeEnd(items.size(), hash);
+        return finished.save(path);
+    }
+};
+
+}
+
+#endif //SJTU_OP_TRACE_HPP
@@ -0,0 +1,159 @@
+#ifndef SJTU_PERF_COUNTERS_HPP
+#define SJTU_PERF_COUNTERS_HPP
+
+#include "bench.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+/**
+ * hardware counters around the timed part of every sample, read through
+ * Linux perf_event_open: cycles, instructions (and IPC), L1D read misses,
+ * LLC misses and branch misses, user space only.
+ *
+ * Each counter is opened on its own, so a machine or VM that lacks some of
+ * them (LLC events often are missing) still reports the rest. When none
+ * can be opened (no PMU, perf_event_paranoid, seccomp, not Linux) the
+ * probe says why once and reports nothing.
+ *
+ * When the kernel multiplexes the counters, each count is extrapolated from
+ * the fraction of the sample it was running for, so it is an estimate. A
+ * counter that was never scheduled during a sample, or could not be read,
+ * is reported as -1 for that sample (and so is ipc), never as a 0 count.
+ */
+class PerfCounters : public Probe {
+private:
+    struct Counter {
+        std::string name;
+        int fd;
+        double value;
+        bool valid;  // read back and running for part of every bracket
+    };
+
+    std::vector<Counter> counters;
+    std::string error;
+
+#ifdef __linux__
+    void open(const char *name, uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd < 0) {
+            if (error.empty()) error = std::string(name) + ": " + strerror(errno);
+            return;
+        }
+        Counter c = {name, fd, 0, true};
+        counters.push_back(c);
+    }
+
+    static uint64_t cacheConfig(uint64_t cache, uint64_t op, uint64_t result) {
+        return cache | (op << 8) | (result << 16);
+    }
+#endif
+
+public:
+    PerfCounters() {
+#ifdef __linux__
+        open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open("l1d_misses", PERF_TYPE_HW_CACHE,
+             cacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+        open("llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        open("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#else
+        error = "perf_event_open is Linux only";
+#endif
+        if (counters.empty()) {
+            fprintf(stderr, "perf counters unavailable (%s); reporting timings only\n", error.c_str());
+        } else if (!error.empty()) {
+            fprintf(stderr, "some perf counters unavailable (%s)\n", error.c_str());
+        }
+    }
+
+    ~PerfCounters() override {
+#ifdef __linux__
+        for (size_t i = 0; i < counters.size(); ++i) close(counters[i].fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available() const {
+        return !counters.empty();
+    }
+
+    void reset() override {
+        for (size_t i = 0; i < counters.size(); ++i) {
+            counters[i].value = 0;
+            counters[i].valid = true;
+        }
+    }
+
+    void start() override {
+#ifdef __linux__
+        for (size_t i = 0; i < counters.size(); ++i) {
+            ioctl(counters[i].fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() override {
+#ifdef __linux__
+        for (size_t i = counters.size(); i-- > 0;) ioctl(counters[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (size_t i = 0; i < counters.size(); ++i) {
+            uint64_t data[3];  // value, time enabled, time running
+            if (read(counters[i].fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+                counters[i].valid = false;
+                continue;
+            }
+            double scale = data[2] < data[1] ? static_cast<double>(data[1]) / data[2] : 1.0;
+            counters[i].value += data[0] * scale;
+        }
+#endif
+    }
+
+    void collect(Metrics &metrics) override {
+        double cycles = -1, instructions = -1;
+        bool hasCycles = false, hasInstructions = false;
+        for (size_t i = 0; i < counters.size(); ++i) {
+            double value = counters[i].valid ? counters[i].value : -1;
+            metrics.push_back(std::make_pair(counters[i].name, value));
+            if (counters[i].name == "cycles") {
+                hasCycles = true;
+                cycles = value;
+            }
+            if (counters[i].name == "instructions") {
+                hasInstructions = true;
+                instructions = value;
+            }
+        }
+        if (hasCycles && hasInstructions) {
+            metrics.push_back(std::make_pair("ipc", cycles > 0 && instructions >= 0 ? instructions / cycles : -1.0));
+        }
+    }
+};
+
+}
+
+#endif //SJTU_PERF_COUNTERS_HPP
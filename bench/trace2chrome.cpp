@@ -0,0 +1,100 @@
+/**
+ * trace2chrome: convert a list trace dump to Chrome trace JSON.
+ *
+ *   trace2chrome DUMP [OUT.json]
+ *
+ * DUMP is written by sjtu::tracing::dump() (list_trace.hpp) in a program
+ * built with SJTU_LIST_TRACE, e.g. through SJTU_LIST_TRACE_FILE. Every
+ * record becomes a complete ("X") event named after the operation, on the
+ * track of the thread that made it, with the list address and resulting
+ * size as arguments. Timestamps are rebased to the first record. Load the
+ * output in chrome://tracing or ui.perfetto.dev. Without OUT the JSON goes
+ * to stdout; a summary per operation goes to stderr.
+ */
+
+#define SJTU_LIST_TRACE
+#include "list_trace.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace {
+
+bool load(const char *path, double &rate, std::vector<sjtu::tracing::record> &records, std::string &error) {
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr) {
+        error = "cannot open file";
+        return false;
+    }
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t count = 0;
+    bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, sjtu::tracing::MAGIC, 4) == 0;
+    if (!ok) {
+        error = "not a list trace dump";
+    } else if (fread(&version, sizeof(version), 1, f) != 1 || version != sjtu::tracing::VERSION) {
+        error = "unsupported dump version";
+        ok = false;
+    } else if (fread(&rate, sizeof(rate), 1, f) != 1 || fread(&count, sizeof(count), 1, f) != 1 || !(rate > 0)) {
+        error = "truncated header";
+        ok = false;
+    } else {
+        records.resize(count);
+        if (count && fread(records.data(), sizeof(sjtu::tracing::record), count, f) != count) {
+            error = "truncated records";
+            ok = false;
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s DUMP [OUT.json]\n", argv[0]);
+        return 2;
+    }
+    double rate = 0;
+    std::vector<sjtu::tracing::record> records;
+    std::string error;
+    if (!load(argv[1], rate, records, error)) {
+        fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+        return 1;
+    }
+    FILE *out = argc == 3 ? fopen(argv[2], "w") : stdout;
+    if (out == nullptr) {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    uint64_t base = records.empty() ? 0 : records[0].start;
+    uint64_t count[sjtu::tracing::OpCount] = {};
+    double totalUs[sjtu::tracing::OpCount] = {};
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < records.size(); ++i) {
+        const sjtu::tracing::record &r = records[i];
+        double ts = (r.start - base) / rate, dur = r.duration / rate;
+        fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"sjtu::list\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                     "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"list\":\"0x%llx\",\"size\":%llu}}\n",
+                i ? "," : "", sjtu::tracing::opName(r.op), r.thread, ts, dur,
+                static_cast<unsigned long long>(r.list), static_cast<unsigned long long>(r.size));
+        if (r.op < sjtu::tracing::OpCount) {
+            ++count[r.op];
+            totalUs[r.op] += dur;
+        }
+    }
+    fprintf(out, "]}\n");
+    bool ok = !ferror(out);
+    if (out != stdout) ok = fclose(out) == 0 && ok;
+
+    fprintf(stderr, "%zu records\n", records.size());
+    for (uint32_t op = 0; op < sjtu::tracing::OpCount; ++op) {
+        if (count[op]) {
+            fprintf(stderr, "  %-12s %10llu  mean %.3f us\n", sjtu::tracing::opName(op),
+                    static_cast<unsigned long long>(count[op]), totalUs[op] / count[op]);
+        }
+    }
+    return ok ? 0 : 1;
+}
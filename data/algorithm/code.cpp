@@ -0,0 +1,373 @@
+// Checks for algorithm.hpp against the standard library
+
+#include "algorithm.hpp"
+#include "list.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+std::mt19937 rng(20220201);
+
+/**
+ * only has operator<, no operator<= / ==
+ */
+class Key {
+private:
+    int value;
+
+public:
+    explicit Key(int value) : value(value) {}
+
+    Key(const Key &other) : value(other.value) {}
+
+    bool operator<(const Key &rhs) const {
+        return value < rhs.value;
+    }
+};
+
+/**
+ * wider than half a cache line, counts live copies and can be told to throw
+ * from the copy constructor after a number of copies
+ */
+class Fragile {
+private:
+    int value;
+    char padding[44];
+
+public:
+    static int live, copiesLeft;
+
+    explicit Fragile(int value) : value(value), padding() {
+        ++live;
+    }
+
+    Fragile(const Fragile &other) : value(other.value), padding() {
+        if (copiesLeft >= 0 && copiesLeft-- == 0) throw 0;
+        ++live;
+    }
+
+    ~Fragile() {
+        --live;
+    }
+
+    bool operator<(const Fragile &rhs) const {
+        return value < rhs.value;
+    }
+};
+
+int Fragile::live = 0, Fragile::copiesLeft = -1;
+
+/**
+ * compared by key only; id tells equal keys apart to check stability
+ */
+struct Tagged {
+    int key, id;
+
+    Tagged(int key, int id) : key(key), id(id) {}
+
+    bool operator<(const Tagged &rhs) const {
+        return key < rhs.key;
+    }
+
+    bool operator==(const Tagged &rhs) const {
+        return key == rhs.key && id == rhs.id;
+    }
+};
+
+std::vector<Tagged> taggedArray(int n, int range) {
+    std::vector<Tagged> a;
+    for (int i = 0; i < n; ++i) a.push_back(Tagged(static_cast<int>(rng() % range), i));
+    return a;
+}
+
+std::vector<int> sortedArray(int n, int range) {
+    std::vector<int> a(n);
+    for (int i = 0; i < n; ++i) a[i] = static_cast<int>(rng() % range);
+    std::sort(a.begin(), a.end());
+    return a;
+}
+
+bool testSort() {
+    for (int n : {0, 1, 2, 3, 10, 1000, 100000}) {
+        for (int range : {1, 16, 1 << 30}) {
+            std::vector<int> a(n);
+            for (int i = 0; i < n; ++i) a[i] = static_cast<int>(rng() % range);
+            std::vector<int> b = a;
+            sjtu::sort<int>(a.data(), a.data() + n, [](const int &x, const int &y) { return x < y; });
+            std::sort(b.begin(), b.end());
+            if (a != b) return false;
+        }
+    }
+    return true;
+}
+
+bool testBounds() {
+    for (int n : {0, 1, 2, 3, 7, 8, 9, 1000, 4097}) {
+        for (int range : {1, 5, 1000000}) {
+            std::vector<int> a = sortedArray(n, range);
+            for (int q = -1; q <= range && q < 2000; ++q) {
+                if (sjtu::lower_bound(a.data(), a.data() + n, q) - a.data() !=
+                    std::lower_bound(a.begin(), a.end(), q) - a.begin()) return false;
+                if (sjtu::upper_bound(a.data(), a.data() + n, q) - a.data() !=
+                    std::upper_bound(a.begin(), a.end(), q) - a.begin()) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool testBoundsComparator() {
+    std::vector<int> a = sortedArray(5000, 300);
+    std::reverse(a.begin(), a.end());
+    std::greater<int> cmp;
+    for (int q = -1; q <= 301; ++q) {
+        if (sjtu::lower_bound(a.data(), a.data() + a.size(), q, cmp) - a.data() !=
+            std::lower_bound(a.begin(), a.end(), q, cmp) - a.begin()) return false;
+        if (sjtu::upper_bound(a.data(), a.data() + a.size(), q, cmp) - a.data() !=
+            std::upper_bound(a.begin(), a.end(), q, cmp) - a.begin()) return false;
+    }
+    std::vector<Key> keys;
+    for (int i = 0; i < 100; ++i) keys.push_back(Key(i / 3));
+    for (int q = -1; q <= 34; ++q) {
+        Key *lo = sjtu::lower_bound(keys.data(), keys.data() + keys.size(), Key(q));
+        Key *hi = sjtu::upper_bound(keys.data(), keys.data() + keys.size(), Key(q));
+        int expectLo = q < 0 ? 0 : std::min(3 * q, 100), expectHi = q < 0 ? 0 : std::min(3 * q + 3, 100);
+        if (lo - keys.data() != expectLo || hi - keys.data() != expectHi) return false;
+    }
+    return true;
+}
+
+bool testLowerBoundMany() {
+    std::vector<int> a = sortedArray(20000, 50000);
+    std::vector<int> queries(5000);
+    for (size_t i = 0; i < queries.size(); ++i) queries[i] = static_cast<int>(rng() % 50002) - 1;
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 0) std::sort(queries.begin(), queries.end());  // sorted batch, then an unsorted one
+        std::vector<int *> out(queries.size());
+        sjtu::lower_bound_many(a.data(), a.data() + a.size(), queries.data(), queries.data() + queries.size(), out.data());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            if (out[i] - a.data() != std::lower_bound(a.begin(), a.end(), queries[i]) - a.begin()) return false;
+        }
+        std::shuffle(queries.begin(), queries.end(), rng);
+    }
+    int *none = nullptr;
+    sjtu::lower_bound_many(a.data(), a.data(), queries.data(), queries.data() + 1, &none);
+    return none == a.data();
+}
+
+bool testEytzinger() {
+    for (int n : {0, 1, 2, 3, 15, 16, 17, 1000, 65537}) {
+        std::vector<int> a = sortedArray(n, n * 2 + 1);
+        sjtu::eytzinger_index<int> index(a.data(), a.data() + n);
+        if (index.size() != static_cast<size_t>(n)) return false;
+        for (int q = -1; q <= 2 * n + 1; q += (n > 1000 ? 7 : 1)) {
+            if (index.lower_bound(q) - a.data() != std::lower_bound(a.begin(), a.end(), q) - a.begin()) return false;
+            if (index.upper_bound(q) - a.data() != std::upper_bound(a.begin(), a.end(), q) - a.begin()) return false;
+        }
+    }
+    std::vector<Key> keys;
+    for (int i = 0; i < 50; ++i) keys.push_back(Key(i * 2));
+    sjtu::eytzinger_index<Key> keyIndex(keys.data(), keys.data() + keys.size());
+    for (int q = -1; q <= 100; ++q) {
+        if (keyIndex.lower_bound(Key(q)) - keys.data() != (q <= 0 ? 0 : std::min((q + 1) / 2, 50))) return false;
+    }
+    std::vector<Fragile> wide;
+    wide.reserve(100);
+    for (int i = 0; i < 100; ++i) wide.push_back(Fragile(i * 2));
+    {
+        sjtu::eytzinger_index<Fragile> wideIndex(wide.data(), wide.data() + wide.size());
+        for (int q = -1; q <= 200; ++q) {
+            if (wideIndex.upper_bound(Fragile(q)) - wide.data() != std::min(q / 2 + (q >= 0), 100)) return false;
+        }
+    }
+    // a copy that throws half way leaves no element behind
+    Fragile::copiesLeft = 50;
+    bool thrown = false;
+    try {
+        sjtu::eytzinger_index<Fragile> wideIndex(wide.data(), wide.data() + wide.size());
+    } catch (int) {
+        thrown = true;
+    }
+    Fragile::copiesLeft = -1;
+    return thrown && Fragile::live == 100;
+}
+
+bool testStableSort() {
+    for (int n : {0, 1, 2, 3, 16, 17, 100, 1000, 100000}) {
+        for (int range : {1, 7, 1 << 30}) {
+            std::vector<Tagged> a = taggedArray(n, range), b = a, c = a;
+            sjtu::stable_sort(a.data(), a.data() + n);
+            std::stable_sort(b.begin(), b.end());
+            if (a != b) return false;
+            // the fallback when no buffer can be allocated
+            sjtu::detail::mergeSort(c.data(), c.data() + n, static_cast<Tagged *>(nullptr), 0, std::less<Tagged>());
+            if (c != b) return false;
+        }
+    }
+    std::vector<int> d = sortedArray(1000, 100);
+    sjtu::stable_sort(d.data(), d.data() + d.size(), std::greater<int>());
+    return std::is_sorted(d.begin(), d.end(), std::greater<int>());
+}
+
+bool testMerge() {
+    for (int n1 : {0, 1, 5, 300}) {
+        for (int n2 : {0, 1, 4, 1000}) {
+            std::vector<Tagged> x = taggedArray(n1, 10), y = taggedArray(n2, 10);
+            for (size_t i = 0; i < y.size(); ++i) y[i].id += n1;
+            std::stable_sort(x.begin(), x.end());
+            std::stable_sort(y.begin(), y.end());
+            std::vector<Tagged> out(n1 + n2, Tagged(0, 0)), expect(n1 + n2, Tagged(0, 0));
+            Tagged *end = sjtu::merge(x.data(), x.data() + n1, y.data(), y.data() + n2, out.data());
+            std::merge(x.begin(), x.end(), y.begin(), y.end(), expect.begin());
+            if (end != out.data() + out.size() || out != expect) return false;
+        }
+    }
+    return true;
+}
+
+bool testInplaceMerge() {
+    for (int n : {0, 1, 2, 10, 1000, 20000}) {
+        for (int range : {1, 3, 1000000}) {
+            std::vector<Tagged> a = taggedArray(n, range);
+            size_t mid = n ? rng() % (n + 1) : 0;
+            std::stable_sort(a.begin(), a.begin() + mid);
+            std::stable_sort(a.begin() + mid, a.end());
+            std::vector<Tagged> expect = a;
+            std::inplace_merge(expect.begin(), expect.begin() + mid, expect.end());
+            for (size_t bufSize : {static_cast<size_t>(0), static_cast<size_t>(3), a.size()}) {
+                std::vector<Tagged> b = a, buf(bufSize, Tagged(0, 0));
+                sjtu::detail::mergeAdaptive(b.data(), b.data() + mid, b.data() + b.size(), buf.data(), bufSize,
+                                            std::less<Tagged>());
+                if (b != expect) return false;
+            }
+            sjtu::inplace_merge(a.data(), a.data() + mid, a.data() + a.size());
+            if (a != expect) return false;
+        }
+    }
+    return true;
+}
+
+bool testStableSortIntegers() {
+    // a sorting network sorts everything iff it sorts every 0/1 input
+    for (int mask = 0; mask < 256; ++mask) {
+        int bits[8];
+        for (int i = 0; i < 8; ++i) bits[i] = mask >> i & 1;
+        sjtu::detail::sortingNetwork8(bits);
+        if (!std::is_sorted(bits, bits + 8)) return false;
+    }
+    for (int n : {0, 1, 7, 8, 9, 16, 17, 1000, 100001}) {
+        for (int range : {1, 7, 1 << 30}) {
+            std::vector<long long> a(n);
+            for (int i = 0; i < n; ++i) a[i] = static_cast<long long>(rng() % range) - range / 2;
+            std::vector<long long> b = a;
+            sjtu::stable_sort(a.data(), a.data() + n);
+            std::sort(b.begin(), b.end());
+            if (a != b) return false;
+        }
+    }
+    return true;
+}
+
+bool testListSortByValue() {
+    for (int n : {0, 1, 2, 9, 1000, 50000}) {
+        std::vector<Tagged> a = taggedArray(n, 13);
+        sjtu::list<Tagged> tagged;
+        sjtu::list<unsigned char> bytes;
+        std::vector<unsigned char> expectBytes;
+        for (size_t i = 0; i < a.size(); ++i) {
+            tagged.push_back(a[i]);
+            bytes.push_back(static_cast<unsigned char>(a[i].key * 31 + a[i].id));
+            expectBytes.push_back(static_cast<unsigned char>(a[i].key * 31 + a[i].id));
+        }
+        sjtu::list<Tagged>::iterator first = tagged.begin();
+        tagged.sort();
+        bytes.sort();
+        std::stable_sort(a.begin(), a.end());
+        std::sort(expectBytes.begin(), expectBytes.end());
+        if (n && first != tagged.begin()) return false;  // nodes stay, values move
+        size_t i = 0;
+        for (sjtu::list<Tagged>::iterator it = tagged.begin(); it != tagged.end(); ++it, ++i) {
+            if (!(*it == a[i])) return false;
+        }
+        i = 0;
+        for (sjtu::list<unsigned char>::iterator it = bytes.begin(); it != bytes.end(); ++it, ++i) {
+            if (*it != expectBytes[i]) return false;
+        }
+        if (tagged.size() != a.size() || bytes.size() != expectBytes.size()) return false;
+    }
+    return true;
+}
+
+/**
+ * every vector kernel this CPU has must give the scalar sjtu::sort result
+ * bit for bit; a range it may not take (-0.0, NaN) is left alone.
+ */
+template<typename T>
+bool simdMatchesScalar(int n, int range) {
+    std::vector<T> a(n);
+    for (int i = 0; i < n; ++i) a[i] = static_cast<T>(static_cast<long long>(rng() % range) - range / 2) / 2;
+    std::vector<T> expect = a;
+    sjtu::sort<T>(expect.data(), expect.data() + n, [](const T &x, const T &y) { return x < y; });
+    for (sjtu::simd::level l : {sjtu::simd::SSE42, sjtu::simd::AVX2}) {
+        std::vector<T> b = a;
+        if (!sjtu::simd::sort(b.data(), b.data() + n, l)) continue;
+        if (n && memcmp(b.data(), expect.data(), n * sizeof(T)) != 0) return false;
+    }
+    std::vector<T> c = a;
+    sjtu::sort(c.data(), c.data() + n);
+    return !n || memcmp(c.data(), expect.data(), n * sizeof(T)) == 0;
+}
+
+bool testSortKernels() {
+    for (int n : {0, 1, 2, 7, 8, 9, 31, 32, 33, 64, 65, 1000, 100000}) {
+        for (int range : {1, 3, 1000, 1 << 30}) {
+            if (!simdMatchesScalar<int>(n, range) || !simdMatchesScalar<long long>(n, range) ||
+                !simdMatchesScalar<float>(n, range) || !simdMatchesScalar<double>(n, range)) return false;
+        }
+    }
+    std::vector<double> special = {1.0, -0.0, 0.0, -2.5};
+    if (sjtu::simd::sort(special.data(), special.data() + special.size())) return false;
+    special.push_back(0.0 / 0.0);
+    return !sjtu::simd::sort(special.data(), special.data() + special.size());
+}
+
+int main() {
+    bool (*testList[])() = {
+            testSort, testBounds, testBoundsComparator, testLowerBoundMany, testEytzinger,
+            testStableSort, testMerge, testInplaceMerge, testStableSortIntegers, testListSortByValue,
+            testSortKernels
+    };
+    const char *Messages[] = {
+            "Test 1: Testing sort()...",
+            "Test 2: Testing lower_bound() & upper_bound()...",
+            "Test 3: Testing lower_bound() & upper_bound() with comparators...",
+            "Test 4: Testing lower_bound_many()...",
+            "Test 5: Testing eytzinger_index...",
+            "Test 6: Testing stable_sort()...",
+            "Test 7: Testing merge()...",
+            "Test 8: Testing inplace_merge()...",
+            "Test 9: Testing stable_sort() on integers...",
+            "Test 10: Testing list::sort() by value...",
+            "Test 11: Testing sort() vector kernels...",
+    };
+
+    bool okay = true;
+    for (size_t i = 0; i < sizeof(testList) / sizeof(testList[0]); ++i) {
+        printf("%s", Messages[i]);
+        if (testList[i]()) {
+            printf("Passed\n");
+        } else {
+            okay = false;
+            printf("Failed\n");
+        }
+    }
+
+    if (okay)
+        printf("Congratulations, you have passed all tests!\n");
+    else printf("Unfortunately, you failed in some of the tests.\n");
+    return 0;
+}
@@ -0,0 +1,545 @@
+// Checks for class-bint.hpp arithmetic against reference results
+
+#include "class-bint.hpp"
+
+#ifdef LIST_ALLOC_COUNTER
+#include "alloc_counter.hpp"
+#define ALLOC_FORBIDDEN(name) alloc::ExpectNoAlloc allocRegion(name)
+#define ALLOC_VIOLATIONS() alloc::violations()
+#else
+#define ALLOC_FORBIDDEN(name)
+#define ALLOC_VIOLATIONS() 0
+#endif
+
+#include <cstdio>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::mt19937 rng(20220301);
+
+using Util::BintKernel::limb;
+
+std::vector<limb> randomLimbs(size_t n, int mode) {
+    std::vector<limb> a(n);
+    for (size_t i = 0; i < n; ++i) {
+        // 0: random, 1: all BASE - 1 (longest carries), 2: sparse
+        a[i] = mode == 1 ? Util::BintKernel::BASE - 1 : mode == 2 ? (rng() % 7 == 0 ? 1 : 0) :
+               static_cast<limb>(rng() % Util::BintKernel::BASE);
+    }
+    return a;
+}
+
+std::string str(const Util::Bint &x) {
+    std::ostringstream ss;
+    ss << x;
+    return ss.str();
+}
+
+std::string nines(size_t k) {
+    return std::string(k, '9');
+}
+
+bool testMultiplyKernels() {
+    typedef void (*Kernel)(const limb *, size_t, const limb *, size_t, limb *);
+    Kernel kernels[] = {
+            Util::BintKernel::mulKaratsuba, Util::BintKernel::mulToom3, Util::BintKernel::mulNtt,
+            Util::BintKernel::multiply
+    };
+    const size_t sizes[][2] = {
+            {1, 1}, {5, 3}, {31, 31}, {32, 32}, {33, 40}, {64, 63}, {100, 51}, {100, 50}, {255, 256},
+            {256, 256}, {300, 290}, {700, 500}, {1000, 20}, {1500, 1499}, {3000, 2100}
+    };
+    for (const size_t *nm : sizes) {
+        for (int mode = 0; mode < 3; ++mode) {
+            std::vector<limb> a = randomLimbs(nm[0], mode), b = randomLimbs(nm[1], mode);
+            std::vector<limb> expect(nm[0] + nm[1]), got(nm[0] + nm[1]);
+            Util::BintKernel::mulSchoolbook(a.data(), a.size(), b.data(), b.size(), expect.data());
+            for (Kernel kernel : kernels) {
+                kernel(a.data(), a.size(), b.data(), b.size(), got.data());
+                if (got != expect) return false;
+                kernel(b.data(), b.size(), a.data(), a.size(), got.data());
+                if (got != expect) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool testNtt() {
+    // large enough for operator* to pick the transform, including lengths
+    // just past a power of two and squaring, which transforms only once
+    const size_t sizes[][2] = {{2560, 2560}, {2049, 2048}, {4097, 2600}, {12000, 2560}, {4000, 4000}};
+    for (const size_t *nm : sizes) {
+        for (int mode = 0; mode < 3; ++mode) {
+            std::vector<limb> a = randomLimbs(nm[0], mode), b = randomLimbs(nm[1], mode);
+            std::vector<limb> expect(nm[0] + nm[1]), got(nm[0] + nm[1]);
+            Util::BintKernel::mulSchoolbook(a.data(), a.size(), b.data(), b.size(), expect.data());
+            Util::BintKernel::mulNtt(a.data(), a.size(), b.data(), b.size(), got.data());
+            if (got != expect) return false;
+            Util::BintKernel::multiply(b.data(), b.size(), a.data(), a.size(), got.data());
+            if (got != expect) return false;
+            std::vector<limb> square(2 * nm[0]), squareExpect(2 * nm[0]);
+            Util::BintKernel::mulSchoolbook(a.data(), a.size(), a.data(), a.size(), squareExpect.data());
+            Util::BintKernel::mulNtt(a.data(), a.size(), a.data(), a.size(), square.data());
+            if (square != squareExpect) return false;
+        }
+    }
+    Util::Bint x(nines(40000));
+    return str(x * x) == nines(39999) + "8" + std::string(39999, '0') + "1";
+}
+
+bool testMultiply() {
+    // (10^k - 1)^2 = 9..98 0..01
+    for (size_t k : {1, 4, 5, 127, 128, 1000, 4001, 12000}) {
+        Util::Bint x(nines(k));
+        std::string expect = nines(k - 1) + "8" + std::string(k - 1, '0') + "1";
+        if (str(x * x) != expect) return false;
+    }
+    if (str(Util::Bint(-12345) * Util::Bint(6789)) != "-83810205") return false;
+    if (str(Util::Bint(-12345) * Util::Bint(-6789)) != "83810205") return false;
+    if (str(Util::Bint(-12345) * Util::Bint(0)) != "0") return false;
+    Util::Bint big(std::string("123456789") + std::string(3000, '0'));
+    return str(big * Util::Bint(-1000)) == "-123456789" + std::string(3003, '0');
+}
+
+bool testConversions() {
+    // each pair is checked as long long arithmetic and through Bint
+    std::uniform_int_distribution<long long> dist(-100000000000000000LL, 100000000000000000LL);
+    for (int i = 0; i < 2000; ++i) {
+        long long a = dist(rng) >> (rng() % 60), b = dist(rng) >> (rng() % 60);
+        Util::Bint x(a), y(std::to_string(b));
+        if (str(x) != std::to_string(a) || str(y) != std::to_string(b)) return false;
+        if (str(x + y) != std::to_string(a + b) || str(x - y) != std::to_string(a - b)) return false;
+        if ((x < y) != (a < b) || (x <= y) != (a <= b) || (x > y) != (a > b) || (x >= y) != (a >= b)) return false;
+        if ((x == y) != (a == b) || (x != y) != (a != b)) return false;
+    }
+    if (str(Util::Bint(-9223372036854775807LL - 1)) != "-9223372036854775808") return false;
+    if (str(Util::Bint(-2147483647 - 1)) != "-2147483648") return false;
+    if (str(Util::Bint(std::string("000000000000000000123"))) != "123") return false;
+    if (str(Util::Bint(std::string("1000000000"))) != "1000000000") return false;
+    if (Util::Bint(std::string("-0")) != Util::Bint(0) || -Util::Bint(0) < Util::Bint(0)) return false;
+    if (str(Util::Bint(-7) - Util::Bint(-7)) != "0" || Util::Bint(-7) - Util::Bint(-7) != Util::Bint(0)) return false;
+    Util::Bint assigned(-5);
+    assigned = 3;
+    if (str(assigned) != "3") return false;
+    // carries and borrows across many limbs, with operands of unequal length
+    Util::Bint big(nines(30000)), one(1);
+    std::string power = "1" + std::string(30000, '0');
+    if (str(big + one) != power || str(one + big) != power) return false;
+    if (str(Util::Bint(power) - one) != nines(30000) || str(one - Util::Bint(power)) != "-" + nines(30000)) return false;
+    std::istringstream in("-12345678901234567890 98765432109876543210");
+    Util::Bint p, q;
+    in >> p >> q;
+    return str(p + q) == "86419753208641975320" && str(p) == "-12345678901234567890";
+}
+
+bool testStorage() {
+    // 36 digits fit inline, 37 do not
+    std::string inlineMax = nines(36), heapMin = "1" + std::string(36, '0');
+    Util::Bint small(inlineMax), grown = small + Util::Bint(1);
+    if (str(grown) != heapMin || str(grown - Util::Bint(1)) != inlineMax) return false;
+    Util::Bint copy(grown), target(7);
+    target = grown;
+    if (str(copy) != heapMin || str(target) != heapMin) return false;
+    target = small;
+    if (str(target) != inlineMax) return false;
+    target = target;
+    Util::Bint moved(std::move(grown));
+    if (str(moved) != heapMin || str(grown) != "0") return false;
+    grown = std::move(moved);
+    if (str(grown) != heapMin || str(moved) != "0") return false;
+    moved = std::move(small);
+    if (str(moved) != inlineMax) return false;
+    grown = std::move(moved);
+    if (str(grown) != inlineMax) return false;
+    std::vector<Util::Bint> values;
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(i % 2 ? Util::Bint(i) : Util::Bint(nines(10 * i + 1)));
+    }
+    for (int i = 0; i < 100; ++i) {
+        if (str(values[i]) != (i % 2 ? std::to_string(i) : nines(10 * i + 1))) return false;
+    }
+    // values of up to 36 digits never touch the heap
+    bool okay = true;
+    {
+        ALLOC_FORBIDDEN("small Bint");
+        for (long long i = -1000; i < 1000; ++i) {
+            Util::Bint x(i * 1000000007LL), y(static_cast<int>(i)), z = x;
+            z = x * y + Util::Bint(i) - y;
+            Util::Bint w(std::move(z));
+            okay = okay && (w == x * y + Util::Bint(i) - y) && (x < y) == (i * 1000000007LL < i);
+        }
+    }
+    return okay && !ALLOC_VIOLATIONS();
+}
+
+bool testCompound() {
+    // against long long arithmetic, with rvalue operands in every position
+    std::uniform_int_distribution<long long> dist(-3000000000LL, 3000000000LL);
+    for (int i = 0; i < 2000; ++i) {
+        long long a = dist(rng) >> (rng() % 32), b = dist(rng) >> (rng() % 32);
+        Util::Bint x(a), y(b);
+        Util::Bint sum = x, difference = x, product = x;
+        sum += y;
+        difference -= y;
+        product *= y;
+        if (str(sum) != std::to_string(a + b) || str(difference) != std::to_string(a - b)) return false;
+        if (str(product) != std::to_string(a * b)) return false;
+        if (str(Util::Bint(a) + y) != std::to_string(a + b) || str(x + Util::Bint(b)) != std::to_string(a + b)) return false;
+        if (str(Util::Bint(a) - y) != std::to_string(a - b) || str(x - Util::Bint(b)) != std::to_string(a - b)) return false;
+        if (str(Util::Bint(a) - Util::Bint(b)) != std::to_string(a - b)) return false;
+        if (str(Util::Bint(a) + Util::Bint(b)) != std::to_string(a + b)) return false;
+    }
+    // aliasing and carries past the current length
+    Util::Bint x(nines(50));
+    x += x;
+    if (str(x) != "1" + nines(49) + "8") return false;
+    x -= x;
+    if (str(x) != "0" || x != Util::Bint(0)) return false;
+    Util::Bint y(std::string("-1") + std::string(40, '0'));
+    y *= y;
+    if (str(y) != "1" + std::string(80, '0')) return false;
+    Util::Bint z(5);
+    z -= Util::Bint(nines(40));
+    if (str(z) != "-" + nines(39) + "4") return false;
+
+    // after the first pass the sum has grown to its final capacity, so
+    // the second one runs without allocating
+    std::vector<Util::Bint> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(Util::Bint((i % 3 ? "" : "-") + nines(100 + i % 50)));
+    }
+    Util::Bint sum, expect;
+    for (const Util::Bint &v : values) expect = expect + v;
+    for (const Util::Bint &v : values) sum += v;
+    if (sum != expect) return false;
+    {
+        ALLOC_FORBIDDEN("Bint +=");
+        sum = 0;
+        for (const Util::Bint &v : values) {
+            sum += v;
+            sum -= v;
+            sum += v;
+        }
+    }
+    return sum == expect && !ALLOC_VIOLATIONS();
+}
+
+bool testDivision() {
+    typedef void (*Kernel)(const limb *, size_t, const limb *, size_t, limb *, limb *);
+    Kernel kernels[] = {
+            Util::BintKernel::divKnuth, Util::BintKernel::divBurnikelZiegler, Util::BintKernel::divide
+    };
+    const size_t sizes[][2] = {
+            {1, 1}, {5, 1}, {9, 2}, {40, 20}, {64, 32}, {65, 33}, {100, 31}, {100, 99}, {300, 64},
+            {500, 250}, {1000, 333}, {2000, 1000}, {2500, 100}
+    };
+    for (const size_t *nm : sizes) {
+        for (int mode = 0; mode < 3; ++mode) {
+            std::vector<limb> a = randomLimbs(nm[0], mode), b = randomLimbs(nm[1], 2 - mode);
+            b.back() = std::max<limb>(b.back(), 1);
+            std::vector<limb> expectQ, expectR;
+            for (Kernel kernel : kernels) {
+                std::vector<limb> q(nm[0] - nm[1] + 1), r(nm[1]), back(nm[0] + 1);
+                kernel(a.data(), a.size(), b.data(), b.size(), q.data(), r.data());
+                Util::BintKernel::multiply(q.data(), q.size(), b.data(), b.size(), back.data());
+                Util::BintKernel::addInPlace(back.data(), back.size(), r.data(), r.size());
+                if (back.back() != 0 || !std::equal(a.begin(), a.end(), back.begin())) return false;
+                size_t rLength = Util::BintKernel::trimmed(r.data(), r.size());
+                if (Util::BintKernel::compareLimbs(r.data(), rLength, b.data(), b.size()) >= 0) return false;
+                if (kernel != kernels[0] && (q != expectQ || r != expectR)) return false;
+                expectQ = q;
+                expectR = r;
+            }
+        }
+    }
+    // truncation toward zero, as for long long
+    std::uniform_int_distribution<long long> dist(-3000000000000000000LL, 3000000000000000000LL);
+    for (int i = 0; i < 2000; ++i) {
+        long long a = dist(rng) >> (rng() % 62), b = dist(rng) >> (rng() % 62);
+        if (b == 0) continue;
+        Util::Bint x(a), y(b);
+        if (str(x / y) != std::to_string(a / b) || str(x % y) != std::to_string(a % b)) return false;
+        Util::Bint quotient = x, remainder = x;
+        quotient /= y;
+        remainder %= y;
+        if (quotient != x / y || remainder != x % y) return false;
+    }
+    Util::Bint x(nines(500)), y("1" + std::string(200, '0'));
+    if (str(x / y) != nines(300) || str(x % y) != nines(200)) return false;
+    if (str(-x / y) != "-" + nines(300) || str(x % -y) != nines(200)) return false;
+    if (y / x != Util::Bint(0) || y % x != y) return false;
+    x /= x;
+    y %= y;
+    if (x != Util::Bint(1) || y != Util::Bint(0)) return false;
+    try {
+        x / y;
+        return false;
+    } catch (const std::domain_error &) {
+    }
+    return true;
+}
+
+bool testPowMod() {
+    for (long long base = -7; base <= 7; ++base) {
+        long long expect = 1;
+        for (unsigned exp = 0; exp < 20; ++exp, expect *= base) {
+            if (str(Util::pow(Util::Bint(base), exp)) != std::to_string(expect)) return false;
+        }
+    }
+    Util::Bint power(1);
+    for (int i = 0; i < 3000; ++i) power *= Util::Bint(3);
+    if (Util::pow(Util::Bint(3), 3000) != power) return false;
+
+    // against square-and-multiply on unsigned long long, odd and even moduli
+    for (int i = 0; i < 300; ++i) {
+        long long base = static_cast<long long>(rng()) - (1LL << 31), mod = rng() % 3000000000U + 1;
+        unsigned exp = rng() % 100000;
+        unsigned long long b = static_cast<unsigned long long>(base % mod + mod) % mod, expect = 1 % mod;
+        for (unsigned e = exp; e != 0; e >>= 1, b = b * b % mod) {
+            if (e & 1) expect = expect * b % mod;
+        }
+        Util::Bint result = Util::powmod(Util::Bint(base), Util::Bint(static_cast<long long>(exp)),
+                                         Util::Bint(i % 2 ? mod : -mod));
+        if (str(result) != std::to_string(expect)) return false;
+    }
+    // Fermat's little theorem for the Mersenne primes 2^127 - 1 (limb by
+    // limb Montgomery reduction) and 2^4423 - 1 (product reduction)
+    for (unsigned p : {127U, 4423U}) {
+        Util::Bint prime = Util::pow(Util::Bint(2), p) - Util::Bint(1);
+        if (Util::powmod(Util::Bint(3), prime - Util::Bint(1), prime) != Util::Bint(1)) return false;
+        if (Util::powmod(Util::Bint(-3), prime, prime) != prime - Util::Bint(3)) return false;
+    }
+    // Montgomery and plain reduction agree
+    for (size_t k : {1, 7, 40, 95, 96, 150}) {
+        std::vector<limb> m = randomLimbs(k, 0), x = randomLimbs(k, 0);
+        m.back() = std::max<limb>(m.back(), 1);
+        m[0] |= 1;
+        if (m[0] % 5 == 0) m[0] += 2;
+        x.back() = 0;
+        unsigned e[3] = {static_cast<unsigned>(rng()), static_cast<unsigned>(rng()), 1};
+        std::vector<limb> r1(k), r2(k);
+        Util::BintKernel::powModMontgomery(x.data(), m.data(), k, e, 3, r1.data());
+        Util::BintKernel::powModDivide(x.data(), m.data(), k, e, 3, r2.data());
+        if (r1 != r2) return false;
+    }
+    if (Util::powmod(Util::Bint(nines(50)), Util::Bint(0), Util::Bint(nines(20))) != Util::Bint(1)) return false;
+    if (Util::powmod(Util::Bint(nines(50)), Util::Bint(5), Util::Bint(1)) != Util::Bint(0)) return false;
+    try {
+        Util::powmod(Util::Bint(2), Util::Bint(-1), Util::Bint(7));
+        return false;
+    } catch (const std::domain_error &) {
+    }
+    try {
+        Util::powmod(Util::Bint(2), Util::Bint(1), Util::Bint(0));
+        return false;
+    } catch (const std::domain_error &) {
+    }
+    return true;
+}
+
+bool testStringIO() {
+    // round trips through the string constructor, toChars and both stream operators
+    for (size_t digits : {1, 2, 8, 9, 10, 17, 18, 19, 100, 1000, 30001}) {
+        for (int sign = 0; sign < 2; ++sign) {
+            std::string s = sign ? "-" : "";
+            s += static_cast<char>('1' + rng() % 9);
+            for (size_t i = 1; i < digits; ++i) s += static_cast<char>('0' + rng() % 10);
+            Util::Bint x(s);
+            std::vector<char> buffer(x.bufferSize());
+            if (std::string(buffer.data(), x.toChars(buffer.data())) != s || str(x) != s) return false;
+            std::istringstream in("  " + s + "\n" + s + "7 x");
+            Util::Bint y, z;
+            in >> y >> z;
+            if (y != x || str(z) != s + "7") return false;
+            std::string rest;
+            if (!(in >> rest) || rest != "x") return false;
+        }
+    }
+    Util::Bint x;
+    std::istringstream in("000000000000000000123 -0 --5 - 1000000000 999999999999999999");
+    const char *expect[] = {"123", "0", "5", "0", "1000000000", "999999999999999999"};
+    for (const char *e : expect) {
+        if (!(in >> x) || str(x) != e) return false;
+    }
+    if (in >> x || str(x) != expect[5]) return false;
+    std::istringstream bad("12a4");
+    try {
+        bad >> x;
+        return false;
+    } catch (const std::invalid_argument &) {
+    }
+    // the stream width pads the whole value, as for a string
+    std::ostringstream out;
+    out << std::setw(6) << Util::Bint(-42) << '|' << std::left << std::setfill('*') << std::setw(5) << Util::Bint(7)
+        << '|' << Util::Bint(8);
+    if (out.str() != "   -42|7****|8") return false;
+
+    // reading into a Bint that already has room and formatting into a
+    // caller's buffer do not allocate
+    std::string many;
+    size_t expectChars = 0;
+    for (int i = 0; i < 200; ++i) {
+        many += (i % 2 ? " -" : " ") + nines(1 + i % 60);
+        expectChars += i % 2 + 1 + i % 60;
+    }
+    std::istringstream values(many);
+    Util::Bint value(nines(100));
+    char buffer[128];
+    size_t chars = 0;
+    {
+        ALLOC_FORBIDDEN("Bint operator>> and toChars");
+        while (values >> value) {
+            chars += value.toChars(buffer) - buffer;
+        }
+    }
+    return chars == expectChars && !ALLOC_VIOLATIONS();
+}
+
+bool testSimdKernels() {
+    using namespace Util::BintKernel;
+    const SimdLevel levels[] = {Scalar, SSE42, AVX2};
+    for (size_t n = 0; n < 70; ++n) {
+        for (int mode = 0; mode < 4; ++mode) {
+            // 3: all BASE - 1 against all 0 and 1, the longest carry and
+            // borrow chains
+            std::vector<limb> a = randomLimbs(n, mode == 3 ? 1 : mode), b = randomLimbs(n, mode == 3 ? 2 : 0);
+            for (limb carry = 0; carry < 2; ++carry) {
+                std::vector<limb> sum(n), difference(n), expectSum(n), expectDifference(n);
+                limb expectCarry = addCarry(a.data(), b.data(), expectSum.data(), n, carry, Scalar);
+                limb expectBorrow = subBorrow(a.data(), b.data(), expectDifference.data(), n, carry, Scalar);
+                for (SimdLevel level : levels) {
+                    if (addCarry(a.data(), b.data(), sum.data(), n, carry, level) != expectCarry) return false;
+                    if (subBorrow(a.data(), b.data(), difference.data(), n, carry, level) != expectBorrow) return false;
+                    if (sum != expectSum || difference != expectDifference) return false;
+                    std::vector<limb> inPlace = a;
+                    addCarry(inPlace.data(), b.data(), inPlace.data(), n, carry, level);
+                    if (inPlace != expectSum) return false;
+                }
+            }
+            // a difference at each position, seen from the top
+            for (size_t k = 0; k < n; ++k) {
+                std::vector<limb> c = a;
+                c[k] = c[k] == 0 ? 1 : c[k] - 1;
+                for (SimdLevel level : levels) {
+                    if (compareLimbs(a.data(), n, c.data(), n, level) != (a[k] < c[k] ? -1 : 1)) return false;
+                    if (compareLimbs(c.data(), n, a.data(), n, level) != (a[k] < c[k] ? 1 : -1)) return false;
+                    if (compareLimbs(a.data(), n, a.data(), n, level) != 0) return false;
+                }
+            }
+        }
+    }
+    // ordering of long values against their decimal strings
+    std::vector<std::string> texts;
+    for (int i = 0; i < 300; ++i) {
+        std::string s = i % 3 ? "" : "-";
+        s += static_cast<char>('1' + rng() % 9);
+        size_t digits = 150 + rng() % 3;
+        for (size_t d = 1; d < digits; ++d) s += static_cast<char>('0' + rng() % (i % 2 ? 2 : 10));
+        texts.push_back(s);
+    }
+    auto before = [](const std::string &x, const std::string &y) {
+        bool xMinus = x[0] == '-', yMinus = y[0] == '-';
+        if (xMinus != yMinus) return xMinus;
+        std::string xs = x.substr(xMinus), ys = y.substr(yMinus);
+        bool less = xs.size() != ys.size() ? xs.size() < ys.size() : xs < ys;
+        bool greater = xs.size() != ys.size() ? xs.size() > ys.size() : xs > ys;
+        return xMinus ? greater : less;
+    };
+    for (size_t i = 0; i < texts.size(); ++i) {
+        for (size_t j = 0; j < texts.size(); j += 7) {
+            Util::Bint x(texts[i]), y(texts[j]);
+            bool less = before(texts[i], texts[j]), greater = before(texts[j], texts[i]);
+            if ((x < y) != less || (x > y) != greater || (x <= y) != !greater || (x >= y) != !less) return false;
+            if ((x == y) != (texts[i] == texts[j]) || (x != y) != (texts[i] != texts[j])) return false;
+        }
+    }
+    return true;
+}
+
+using namespace Util::literals;
+
+// evaluated by the compiler
+constexpr auto SEED = 123456789012345678901234567890_bint;
+static_assert(SEED.length == 4 && SEED.data[0] == 234567890, "_bint splits into limbs");
+static_assert(12_bint * 34_bint == 408_bint && -5_bint + 3_bint == -2_bint, "constexpr arithmetic");
+static_assert(1'000'000'000_bint - 1_bint == 999999999_bint, "separators and borrows");
+static_assert(Util::StaticBint<3>(-9000000000000000000LL) < 0_bint && 0_bint == -0_bint, "signs");
+constexpr Util::StaticBint<8> TABLE[] = {1_bint, 999999999999999999999_bint, -SEED, SEED * SEED};
+
+bool testLiterals() {
+    if (str(SEED) != "123456789012345678901234567890" || str(-SEED) != "-123456789012345678901234567890") return false;
+    const char *expect[] = {
+            "1", "999999999999999999999", "-123456789012345678901234567890",
+            "15241578753238836750495351562536198787501905199875019052100"
+    };
+    for (size_t i = 0; i < 4; ++i) {
+        if (Util::Bint(TABLE[i]) != Util::Bint(std::string(expect[i]))) return false;
+    }
+    if (str(000'123_bint) != "123" || str(0_bint) != "0") return false;
+    if (Util::Bint(SEED) + 5_bint != Util::Bint(std::string("123456789012345678901234567895"))) return false;
+
+    // the constexpr operators, run at run time, against Bint
+    std::uniform_int_distribution<long long> dist(-4000000000000000000LL, 4000000000000000000LL);
+    for (int i = 0; i < 2000; ++i) {
+        long long a = dist(rng) >> (rng() % 63), b = dist(rng) >> (rng() % 63);
+        Util::StaticBint<3> x(a), y(b);
+        Util::Bint bx(a), by(b);
+        if (Util::Bint(x + y) != bx + by || Util::Bint(x - y) != bx - by || Util::Bint(x * y) != bx * by) return false;
+        if ((x < y) != (bx < by) || (x == y) != (bx == by) || (x >= y) != (bx >= by)) return false;
+        if (Util::Bint(-x) != -bx) return false;
+    }
+    try {
+        Util::StaticBint<2> narrow(SEED);
+        return false;
+    } catch (const std::length_error &) {
+    }
+    // up to four limbs the Bint stays inline
+    bool same;
+    {
+        ALLOC_FORBIDDEN("Bint from _bint");
+        Util::Bint x = 999999999999999999999999999999999999_bint, y = SEED;
+        same = x > y && y == -Util::Bint(TABLE[2]);
+    }
+    return same && !ALLOC_VIOLATIONS();
+}
+
+int main() {
+    bool (*testList[])() = {
+            testMultiplyKernels, testMultiply, testNtt, testConversions, testStorage,
+            testCompound, testDivision, testPowMod, testStringIO, testSimdKernels, testLiterals
+    };
+    const char *Messages[] = {
+            "Test 1: Testing multiplication kernels...",
+            "Test 2: Testing operator*...",
+            "Test 3: Testing NTT multiplication...",
+            "Test 4: Testing conversions, comparisons and add/sub...",
+            "Test 5: Testing inline and heap storage...",
+            "Test 6: Testing compound assignment...",
+            "Test 7: Testing division and modulo...",
+            "Test 8: Testing pow and powmod...",
+            "Test 9: Testing string conversion and stream I/O...",
+            "Test 10: Testing SIMD add, subtract and compare...",
+            "Test 11: Testing _bint literals and StaticBint...",
+    };
+
+    bool okay = true;
+    for (size_t i = 0; i < sizeof(testList) / sizeof(testList[0]); ++i) {
+        printf("%s", Messages[i]);
+        if (testList[i]()) {
+            printf("Passed\n");
+        } else {
+            okay = false;
+            printf("Failed\n");
+        }
+    }
+
+    if (okay)
+        printf("Congratulations, you have passed all tests!\n");
+    else printf("Unfortunately, you failed in some of the tests.\n");
+    return 0;
+}
@@ -5,9 +5,98 @@
 #include <vector>
 #include <stdexcept>
 
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__) && \
+    !defined(UTIL_NO_SIMD_BINT)
+#include <immintrin.h>
+#define UTIL_BINT_SIMD_X86 1
+#endif
+
 namespace Util {
 
-const size_t MIN_CAPACITY = 2048;
+// limbs stored inside the object (36 digits); longer values move to the
+// heap, in buffers of a power of two times this many limbs
+const size_t INLINE_CAPACITY = 4;
+
+// operand sizes, in limbs, from which operator* uses Karatsuba, Toom-3
+// and the number-theoretic transform
+const size_t KARATSUBA_THRESHOLD = 32;
+const size_t TOOM3_THRESHOLD = 256;
+const size_t NTT_THRESHOLD = 2560;
+// longest product, in limbs, the transform can take (2^23 divides p - 1
+// for all three NTT primes)
+const size_t NTT_MAX_LENGTH = size_t(1) << 23;
+// divisor and quotient size, in limbs, from which operator/ and operator%
+// use Burnikel-Ziegler instead of Knuth's algorithm D
+const size_t DIV_RECURSIVE_THRESHOLD = 32;
+// modulus size, in limbs, from which Montgomery reduction is done with
+// multiplications rather than limb by limb
+const size_t MONTGOMERY_PRODUCT_THRESHOLD = 96;
+
+/*
+ * Multiplication kernels over little-endian limb arrays, each limb in
+ * [0, BASE). They write all n + m limbs of the product to r, which must
+ * not overlap the operands. multiply() picks the algorithm by size; the
+ * others run their own algorithm at the top level (sub-products still go
+ * through multiply()) and are exposed for tests and benchmarks.
+ */
+namespace BintKernel {
+
+typedef int limb;
+// nine decimal digits per limb; sums of two limbs still fit a limb and
+// products are taken in 64 bits
+const limb BASE = 1000000000;
+const int BASE_DIGITS = 9;
+
+void mulSchoolbook(const limb *a, size_t n, const limb *b, size_t m, limb *r);
+void mulKaratsuba(const limb *a, size_t n, const limb *b, size_t m, limb *r);
+void mulToom3(const limb *a, size_t n, const limb *b, size_t m, limb *r);
+void mulNtt(const limb *a, size_t n, const limb *b, size_t m, limb *r);
+void multiply(const limb *a, size_t n, const limb *b, size_t m, limb *r);
+
+/*
+ * Division of a[0, n) by b[0, m), n >= m, b[m - 1] != 0: the quotient goes
+ * to q[0, n - m], the remainder to r[0, m). divide() picks the algorithm.
+ */
+void divKnuth(const limb *a, size_t n, const limb *b, size_t m, limb *q, limb *r);
+void divBurnikelZiegler(const limb *a, size_t n, const limb *b, size_t m, limb *q, limb *r);
+void divide(const limb *a, size_t n, const limb *b, size_t m, limb *q, limb *r);
+
+/*
+ * r[0, k) = x^e mod m for x < m, both k limbs, m[k - 1] != 0, and e given
+ * as `words` little-endian 32-bit words. powMod() takes the Montgomery
+ * path when m is coprime to BASE (odd and not a multiple of 5), and
+ * reduces by division otherwise.
+ */
+void powModMontgomery(const limb *x, const limb *m, size_t k, const unsigned *e, size_t words, limb *r);
+void powModDivide(const limb *x, const limb *m, size_t k, const unsigned *e, size_t words, limb *r);
+void powMod(const limb *x, const limb *m, size_t k, const unsigned *e, size_t words, limb *r);
+
+/*
+ * Addition, subtraction and comparison behind the Bint operators, with
+ * AVX2 and SSE4.2 versions picked at run time on Linux x86-64 with GCC
+ * (define UTIL_NO_SIMD_BINT to turn them off). The overloads without a
+ * level use the best one the CPU runs on all but short inputs; a level
+ * above that is lowered to it.
+ */
+enum SimdLevel {
+	Scalar, SSE42, AVX2
+};
+SimdLevel simdDetected();
+const char *simdLevelName(SimdLevel level);
+// r[0, n) = a[0, n) + b[0, n) + carry, returning the carry out; r may be a or b
+limb addCarry(const limb *a, const limb *b, limb *r, size_t n, limb carry);
+limb addCarry(const limb *a, const limb *b, limb *r, size_t n, limb carry, SimdLevel level);
+// r[0, n) = a[0, n) - b[0, n) - borrow, returning the borrow out; r may be a or b
+limb subBorrow(const limb *a, const limb *b, limb *r, size_t n, limb borrow);
+limb subBorrow(const limb *a, const limb *b, limb *r, size_t n, limb borrow, SimdLevel level);
+// sign of a[0, n) - b[0, m), both trimmed
+int compareLimbs(const limb *a, size_t n, const limb *b, size_t m);
+int compareLimbs(const limb *a, size_t n, const limb *b, size_t m, SimdLevel level);
+
+}
+
+template<size_t N>
+struct StaticBint;
 
 class Bint {
 	class NewSpaceFailed : public std::runtime_error {
@@ -18,26 +107,59 @@ class Bint {
 	public:
 		BadCast();
 	};
+	class DivideByZero : public std::domain_error {
+	public:
+		DivideByZero();
+	};
+	class NegativeExponent : public std::domain_error {
+	public:
+		NegativeExponent();
+	};
 	bool isMinus = false;
 	size_t length;
-	int *data = nullptr;
-	size_t capacity = MIN_CAPACITY;
+	int *data = inlineData;
+	size_t capacity = INLINE_CAPACITY;
+	int inlineData[INLINE_CAPACITY] = {};
+	bool _IsInline() const;
 	void _DoubleSpace();
 	void _SafeNewSpace(int *&p, const size_t &len);
+	void _Reserve(size_t capa);
+	void _Grow(size_t capa);
+	void _Release();
+	void _Assign(long long x);
+	void _AddMagnitude(const Bint &rhs);
+	void _SubMagnitude(const Bint &rhs);
+	void _Trim();
+	static int _Compare(const Bint &lhs, const Bint &rhs);
+	static void _DivMod(const Bint &lhs, const Bint &rhs, Bint *quotient, Bint *remainder);
 	explicit Bint(const size_t &capa);
 public:
 	Bint();
 	Bint(int x);
 	Bint(long long x);
-	Bint(std::string x);
+	Bint(const std::string &x);
 	Bint(const Bint &b);
 	Bint(Bint &&b) noexcept;
+	template<size_t N>
+	Bint(const StaticBint<N> &x);
 
 	Bint &operator=(int rhs);
 	Bint &operator=(long long rhs);
 	Bint &operator=(const Bint &rhs);
 	Bint &operator=(Bint &&rhs) noexcept;
 
+	Bint &operator+=(const Bint &rhs);
+	Bint &operator-=(const Bint &rhs);
+	Bint &operator*=(const Bint &rhs);
+	Bint &operator/=(const Bint &rhs);
+	Bint &operator%=(const Bint &rhs);
+
+	// chars toChars() may write: the digits and a sign
+	size_t bufferSize() const;
+	// writes the decimal digits, without a terminator, from out on and
+	// returns the end
+	char *toChars(char *out) const;
+
 	friend Bint abs(const Bint &x);
 	friend Bint abs(Bint &&x);
 
@@ -49,16 +171,282 @@ public:
 	friend bool operator>=(const Bint &lhs, const Bint &rhs);
 
 	friend Bint operator+(const Bint &lhs, const Bint &rhs);
+	friend Bint operator+(Bint &&lhs, const Bint &rhs);
+	friend Bint operator+(const Bint &lhs, Bint &&rhs);
+	friend Bint operator+(Bint &&lhs, Bint &&rhs);
 	friend Bint operator-(const Bint &b);
 	friend Bint operator-(Bint &&b);
 	friend Bint operator-(const Bint &lhs, const Bint &rhs);
+	friend Bint operator-(Bint &&lhs, const Bint &rhs);
+	friend Bint operator-(const Bint &lhs, Bint &&rhs);
+	friend Bint operator-(Bint &&lhs, Bint &&rhs);
 	friend Bint operator*(const Bint &lhs, const Bint &rhs);
+	friend Bint operator/(const Bint &lhs, const Bint &rhs);
+	friend Bint operator%(const Bint &lhs, const Bint &rhs);
+
+	friend Bint pow(const Bint &base, unsigned long long exp);
+	friend Bint powmod(const Bint &base, const Bint &exp, const Bint &mod);
 
 	friend std::istream &operator>>(std::istream &is, Bint &b);
 	friend std::ostream &operator<<(std::ostream &os, const Bint &b);
 
 	~Bint();
 };
+
+namespace BintKernel {
+
+/*
+ * compile-time versions of the limb loops, for StaticBint; r starts out
+ * zero and the returned lengths are trimmed to at least one limb
+ */
+constexpr size_t constTrimmed(const limb *a, size_t n)
+{
+	while (n > 1 && a[n - 1] == 0) {
+		--n;
+	}
+	return n;
+}
+
+constexpr int constCompare(const limb *a, size_t n, const limb *b, size_t m)
+{
+	if (n != m) {
+		return n < m ? -1 : 1;
+	}
+	for (size_t i = n; i-- > 0;) {
+		if (a[i] != b[i]) {
+			return a[i] < b[i] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+// r[0, max(n, m)] = a[0, n) + b[0, m)
+constexpr size_t constAdd(const limb *a, size_t n, const limb *b, size_t m, limb *r)
+{
+	size_t len = n > m ? n : m;
+	limb carry = 0;
+	for (size_t i = 0; i < len; ++i) {
+		limb t = (i < n ? a[i] : 0) + (i < m ? b[i] : 0) + carry;
+		carry = t >= BASE;
+		r[i] = carry ? t - BASE : t;
+	}
+	r[len] = carry;
+	return constTrimmed(r, len + 1);
+}
+
+// r[0, n) = a[0, n) - b[0, m), a >= b
+constexpr size_t constSub(const limb *a, size_t n, const limb *b, size_t m, limb *r)
+{
+	limb borrow = 0;
+	for (size_t i = 0; i < n; ++i) {
+		limb t = a[i] - (i < m ? b[i] : 0) - borrow;
+		borrow = t < 0;
+		r[i] = borrow ? t + BASE : t;
+	}
+	return constTrimmed(r, n);
+}
+
+// r[0, n + m) = a[0, n) * b[0, m)
+constexpr size_t constMul(const limb *a, size_t n, const limb *b, size_t m, limb *r)
+{
+	for (size_t i = 0; i < n; ++i) {
+		unsigned long long carry = 0;
+		for (size_t j = 0; j < m; ++j) {
+			unsigned long long t = r[i + j] + static_cast<unsigned long long>(a[i]) * b[j] + carry;
+			r[i + j] = static_cast<limb>(t % BASE);
+			carry = t / BASE;
+		}
+		r[i + m] = static_cast<limb>(carry);
+	}
+	return constTrimmed(r, n + m);
+}
+
+constexpr bool constDecimal(const char *s, size_t n)
+{
+	for (size_t i = 0; i < n; ++i) {
+		if ((s[i] < '0' || s[i] > '9') && s[i] != '\'') {
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+/*
+ * A Bint of at most N limbs held in a plain array. It is a literal type,
+ * so values can be built, compared and combined at compile time and kept
+ * in read-only data (constexpr tables); a Bint is made from one by copying
+ * the limbs, without parsing. The _bint literal gives one of just enough
+ * limbs for its digits. Arithmetic results are sized for the worst case:
+ * max(N, M) + 1 limbs for + and -, N + M for *.
+ */
+template<size_t N>
+struct StaticBint {
+	static_assert(N > 0, "a StaticBint needs a limb");
+	bool isMinus = false;
+	size_t length = 1;
+	BintKernel::limb data[N] = {};
+
+	constexpr StaticBint() = default;
+	constexpr StaticBint(long long x);
+	// throws std::length_error if x has more than N limbs
+	template<size_t M>
+	constexpr StaticBint(const StaticBint<M> &x);
+};
+
+template<size_t N>
+constexpr StaticBint<N>::StaticBint(long long x)
+	: isMinus(x < 0), length(0)
+{
+	unsigned long long v = x < 0 ? 0ULL - static_cast<unsigned long long>(x) : static_cast<unsigned long long>(x);
+	do {
+		if (length == N) {
+			throw std::length_error("StaticBint capacity exceeded");
+		}
+		data[length++] = static_cast<BintKernel::limb>(v % BintKernel::BASE);
+		v /= BintKernel::BASE;
+	} while (v != 0);
+}
+
+template<size_t N>
+template<size_t M>
+constexpr StaticBint<N>::StaticBint(const StaticBint<M> &x)
+	: isMinus(x.isMinus), length(x.length)
+{
+	if (x.length > N) {
+		throw std::length_error("StaticBint capacity exceeded");
+	}
+	for (size_t i = 0; i < x.length; ++i) {
+		data[i] = x.data[i];
+	}
+}
+
+template<size_t N>
+constexpr StaticBint<N> operator-(const StaticBint<N> &x)
+{
+	StaticBint<N> r = x;
+	r.isMinus = !x.isMinus && (x.length > 1 || x.data[0] != 0);
+	return r;
+}
+
+template<size_t N, size_t M>
+constexpr StaticBint<(N > M ? N : M) + 1> operator+(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	StaticBint<(N > M ? N : M) + 1> r;
+	if (lhs.isMinus == rhs.isMinus) {
+		r.length = BintKernel::constAdd(lhs.data, lhs.length, rhs.data, rhs.length, r.data);
+		r.isMinus = lhs.isMinus;
+	} else if (BintKernel::constCompare(lhs.data, lhs.length, rhs.data, rhs.length) >= 0) {
+		r.length = BintKernel::constSub(lhs.data, lhs.length, rhs.data, rhs.length, r.data);
+		r.isMinus = lhs.isMinus;
+	} else {
+		r.length = BintKernel::constSub(rhs.data, rhs.length, lhs.data, lhs.length, r.data);
+		r.isMinus = rhs.isMinus;
+	}
+	r.isMinus = r.isMinus && (r.length > 1 || r.data[0] != 0);
+	return r;
+}
+
+template<size_t N, size_t M>
+constexpr StaticBint<(N > M ? N : M) + 1> operator-(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	return lhs + -rhs;
+}
+
+template<size_t N, size_t M>
+constexpr StaticBint<N + M> operator*(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	StaticBint<N + M> r;
+	r.length = BintKernel::constMul(lhs.data, lhs.length, rhs.data, rhs.length, r.data);
+	r.isMinus = lhs.isMinus != rhs.isMinus && (r.length > 1 || r.data[0] != 0);
+	return r;
+}
+
+// sign of lhs - rhs
+template<size_t N, size_t M>
+constexpr int compare(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	if (lhs.isMinus != rhs.isMinus) {
+		return lhs.isMinus ? -1 : 1;
+	}
+	int c = BintKernel::constCompare(lhs.data, lhs.length, rhs.data, rhs.length);
+	return lhs.isMinus ? -c : c;
+}
+
+template<size_t N, size_t M>
+constexpr bool operator==(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	return compare(lhs, rhs) == 0;
+}
+
+template<size_t N, size_t M>
+constexpr bool operator!=(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	return compare(lhs, rhs) != 0;
+}
+
+template<size_t N, size_t M>
+constexpr bool operator<(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	return compare(lhs, rhs) < 0;
+}
+
+template<size_t N, size_t M>
+constexpr bool operator>(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	return compare(lhs, rhs) > 0;
+}
+
+template<size_t N, size_t M>
+constexpr bool operator<=(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	return compare(lhs, rhs) <= 0;
+}
+
+template<size_t N, size_t M>
+constexpr bool operator>=(const StaticBint<N> &lhs, const StaticBint<M> &rhs)
+{
+	return compare(lhs, rhs) >= 0;
+}
+
+inline namespace literals {
+
+/*
+ * 123456789012345678901234567890_bint, parsed by the compiler: decimal
+ * digits only, with optional ' separators. A leading 0 does not make it
+ * octal.
+ */
+template<char... Digits>
+constexpr StaticBint<(sizeof...(Digits) + BintKernel::BASE_DIGITS - 1) / BintKernel::BASE_DIGITS> operator""_bint()
+{
+	constexpr char digits[] = {Digits...};
+	static_assert(BintKernel::constDecimal(digits, sizeof...(Digits)),
+	              "_bint takes decimal digits, optionally with ' separators");
+	StaticBint<(sizeof...(Digits) + BintKernel::BASE_DIGITS - 1) / BintKernel::BASE_DIGITS> r;
+	r.length = 0;
+	BintKernel::limb group = 0, scale = 1;
+	for (size_t i = sizeof...(Digits); i-- > 0;) {
+		if (digits[i] == '\'') {
+			continue;
+		}
+		group += (digits[i] - '0') * scale;
+		scale *= 10;
+		if (scale == BintKernel::BASE) {
+			r.data[r.length++] = group;
+			group = 0;
+			scale = 1;
+		}
+	}
+	if (scale != 1 || r.length == 0) {
+		r.data[r.length++] = group;
+	}
+	r.length = BintKernel::constTrimmed(r.data, r.length);
+	return r;
+}
+
+}
+
 }
 
 #include <iomanip>
@@ -68,6 +456,50 @@ namespace Util {
 
 Bint::NewSpaceFailed::NewSpaceFailed() : std::runtime_error("No Enough Memory Space.") {}
 Bint::BadCast::BadCast() : std::invalid_argument("Cannot convert to a Bint object") {}
+namespace BintKernel {
+
+// the value of the n <= BASE_DIGITS decimal digits at p
+limb parseDigits(const char *p, size_t n)
+{
+	limb v = 0;
+	for (size_t i = 0; i < n; ++i) {
+		v = v * 10 + (p[i] - '0');
+	}
+	return v;
+}
+
+const char DIGIT_PAIRS[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+// the BASE_DIGITS digits of x, zero-padded, at out, two at a time
+void formatLimb(limb x, char *out)
+{
+	for (int i = BASE_DIGITS - 2; i > 0; i -= 2) {
+		memcpy(out + i, DIGIT_PAIRS + 2 * (x % 100), 2);
+		x /= 100;
+	}
+	out[0] = static_cast<char>('0' + x);
+}
+
+// the digits of x, unpadded, from out on; returns the end
+char *formatDigits(limb x, char *out)
+{
+	char digits[BASE_DIGITS];
+	formatLimb(x, digits);
+	int first = 0;
+	while (first < BASE_DIGITS - 1 && digits[first] == '0') {
+		++first;
+	}
+	memcpy(out, digits + first, BASE_DIGITS - first);
+	return out + BASE_DIGITS - first;
+}
+
+}
+
+Bint::DivideByZero::DivideByZero() : std::domain_error("Division by zero") {}
+Bint::NegativeExponent::NegativeExponent() : std::domain_error("Negative exponent") {}
 
 void Bint::_SafeNewSpace(int *&p, const size_t &len)
 {
@@ -82,148 +514,169 @@ void Bint::_SafeNewSpace(int *&p, const size_t &len)
 	memset(p, 0, len * sizeof(unsigned int));
 }
 
+bool Bint::_IsInline() const
+{
+	return data == inlineData;
+}
+
 void Bint::_DoubleSpace()
 {
+	_Grow(capacity << 1);
+}
+
+// room for capa limbs; the old contents are dropped
+void Bint::_Reserve(size_t capa)
+{
+	if (capa <= capacity) {
+		return;
+	}
+	size_t newCapacity = capacity;
+	while (newCapacity < capa) {
+		newCapacity <<= 1;
+	}
+	int *newMem = nullptr;
+	_SafeNewSpace(newMem, newCapacity);
+	_Release();
+	data = newMem;
+	capacity = newCapacity;
+}
+
+// room for capa limbs, keeping the value
+void Bint::_Grow(size_t capa)
+{
+	if (capa <= capacity) {
+		return;
+	}
+	size_t newCapacity = capacity;
+	while (newCapacity < capa) {
+		newCapacity <<= 1;
+	}
 	int *newMem = nullptr;
-	_SafeNewSpace(newMem, capacity << 1);
-	memcpy(newMem, data, capacity * sizeof(int));
-	delete[] data;
+	_SafeNewSpace(newMem, newCapacity);
+	memcpy(newMem, data, length * sizeof(int));
+	_Release();
 	data = newMem;
-	capacity <<= 1;
+	capacity = newCapacity;
+}
+
+// back to the empty inline buffer
+void Bint::_Release()
+{
+	if (!_IsInline()) {
+		delete[] data;
+	}
+	data = inlineData;
+	capacity = INLINE_CAPACITY;
 }
 
 Bint::Bint()
 	: length(1)
 {
-	_SafeNewSpace(data, capacity);
 }
 
 Bint::Bint(int x)
-	: length(0)
+	: Bint(static_cast<long long>(x))
 {
-	_SafeNewSpace(data, capacity);
-	if (x < 0) {
-		isMinus = true;
-		x = -x;
-	}
-	while (x) {
-		data[length++] = x % 10000;
-		x /= 10000;
-	}
-	if (!length) {
-		length = 1;
-	}
 }
 
 Bint::Bint(long long x)
 	: length(0)
 {
-	_SafeNewSpace(data, capacity);
-	if (x < 0) {
-		isMinus = true;
-		x = -x;
-	}
-	while (x) {
-		data[length++] = static_cast<unsigned int>(x % 10000);
-		x /= 10000;
-	}
-	if (!length) {
-		length = 1;
-	}
+	_Assign(x);
 }
 
 Bint::Bint(const size_t &capa)
 	: length(1)
 {
-	while (capacity < capa) {
-		capacity <<= 1;
-	}
-	_SafeNewSpace(data, capacity);
+	_Reserve(capa);
 }
 
-Bint::Bint(std::string x)
+Bint::Bint(const std::string &x)
 {
-	while (x[0] == '-') {
+	size_t begin = 0;
+	while (begin < x.length() && x[begin] == '-') {
 		isMinus = !isMinus;
-		x.erase(0, 1);
+		++begin;
 	}
-	while ((capacity << 2) <= x.length()) {
-		capacity <<= 1;
+	for (size_t i = begin; i < x.length(); ++i) {
+		if (x[i] > '9' || x[i] < '0') {
+			throw BadCast();
+		}
 	}
+	size_t digits = x.length() - begin;
+	_Reserve((digits + BintKernel::BASE_DIGITS - 1) / BintKernel::BASE_DIGITS);
 
-	_SafeNewSpace(data, capacity);
-
-	size_t mid = x.length() >> 1;
-	for (size_t i = 0; i < mid; ++i) {
-		std::swap(x[i], x[x.length() - 1 - i]);
+	// limb i holds the BASE_DIGITS digits ending i limbs from the back;
+	// the top one takes what is left over
+	const char *p = x.data() + x.length();
+	length = 0;
+	for (; digits >= BintKernel::BASE_DIGITS; digits -= BintKernel::BASE_DIGITS) {
+		p -= BintKernel::BASE_DIGITS;
+		data[length++] = BintKernel::parseDigits(p, BintKernel::BASE_DIGITS);
 	}
-
-	const static unsigned int pow10[4] = {1, 10, 100, 1000};
-	for (size_t i = 0; i < capacity; ++i) {
-		if ((i << 2) >= x.length()) {
-			length = i;
-			break;
-		}
-		for (size_t j = 0; j < 4; ++j) {
-			if ((i << 2) + j >= x.length()) {
-				break;
-			}
-			if (x[(i << 2) + j] > '9' || x[(i << 2) + j] < '0') {
-				throw BadCast();
-			}
-			data[i] = data[i] + (x[(i << 2) + j] - '0') * pow10[j];
-		}
+	if (digits > 0 || length == 0) {
+		data[length++] = BintKernel::parseDigits(p - digits, digits);
 	}
+	_Trim();
 }
 
 Bint::Bint(const Bint &b)
-	: isMinus(b.isMinus), length(b.length), capacity(b.capacity)
+	: isMinus(b.isMinus), length(b.length)
 {
-	_SafeNewSpace(data, capacity);
-	memcpy(data, b.data, sizeof(unsigned int) * capacity);
+	_Reserve(length);
+	memcpy(data, b.data, sizeof(unsigned int) * length);
 }
 
+template<size_t N>
+Bint::Bint(const StaticBint<N> &x)
+	: isMinus(x.isMinus), length(x.length)
+{
+	_Reserve(length);
+	memcpy(data, x.data, sizeof(BintKernel::limb) * length);
+}
+
+// inline limbs are copied; a heap buffer changes hands and leaves b zero
 Bint::Bint(Bint &&b) noexcept
-	: isMinus(b.isMinus), length(b.length), capacity(b.capacity)
+	: isMinus(b.isMinus), length(b.length)
 {
+	if (b._IsInline()) {
+		memcpy(inlineData, b.inlineData, sizeof(inlineData));
+		return;
+	}
 	data = b.data;
-	b.data = nullptr;
+	capacity = b.capacity;
+	b.data = b.inlineData;
+	b.capacity = INLINE_CAPACITY;
+	b.inlineData[0] = 0;
+	b.isMinus = false;
+	b.length = 1;
 }
 
 Bint &Bint::operator=(int x)
 {
-	memset(data, 0, sizeof(unsigned int) * capacity);
-	length = 0;
-	if (x < 0) {
-		isMinus = true;
-		x = -x;
-	}
-	while (x) {
-		data[length++] = x % 10000;
-		x /= 10000;
-	}
-	if (!length) {
-		length = 1;
-	}
-	return *this;
+	return *this = static_cast<long long>(x);
 }
 
 Bint &Bint::operator=(long long x)
 {
-	memset(data, 0, sizeof(unsigned int) * capacity);
+	_Assign(x);
+	return *this;
+}
+
+void Bint::_Assign(long long x)
+{
+	// the magnitude is taken unsigned, so LLONG_MIN converts too
+	isMinus = x < 0;
+	unsigned long long mag = isMinus ? 0ULL - static_cast<unsigned long long>(x) : x;
 	length = 0;
-	if (x < 0) {
-		isMinus = true;
-		x = -x;
-	}
-	while (x) {
-		data[length++] = static_cast<unsigned int>(x % 10000);
-		x /= 10000;
+	while (mag) {
+		data[length++] = static_cast<BintKernel::limb>(mag % BintKernel::BASE);
+		mag /= BintKernel::BASE;
 	}
 	if (!length) {
+		data[0] = 0;
 		length = 1;
 	}
-	return *this;
 }
 
 Bint &Bint::operator=(const Bint &rhs)
@@ -231,11 +684,8 @@ Bint &Bint::operator=(const Bint &rhs)
 	if (this == &rhs) {
 		return *this;
 	}
-	if (rhs.capacity > capacity) {
-		capacity = rhs.capacity;
-		_SafeNewSpace(data, capacity);
-	}
-	memcpy(data, rhs.data, sizeof(unsigned int) * rhs.capacity);
+	_Reserve(rhs.length);
+	memcpy(data, rhs.data, sizeof(unsigned int) * rhs.length);
 	length = rhs.length;
 	isMinus = rhs.isMinus;
 	return *this;
@@ -246,33 +696,150 @@ Bint &Bint::operator=(Bint &&rhs) noexcept
 	if (this == &rhs) {
 		return *this;
 	}
-	capacity = rhs.capacity;
-	length = rhs.length;
 	isMinus = rhs.isMinus;
+	length = rhs.length;
+	if (rhs._IsInline()) {
+		// keep a heap buffer of our own for later growth
+		memcpy(data, rhs.inlineData, sizeof(rhs.inlineData));
+		return *this;
+	}
+	_Release();
 	data = rhs.data;
-	rhs.data = nullptr;
+	capacity = rhs.capacity;
+	rhs.data = rhs.inlineData;
+	rhs.capacity = INLINE_CAPACITY;
+	rhs.inlineData[0] = 0;
+	rhs.isMinus = false;
+	rhs.length = 1;
 	return *this;
 }
 
+/*
+ * Reads a whitespace-delimited token straight from the stream buffer, like
+ * operator>> for std::string, but packs the digits into limbs as they
+ * arrive: full groups of BASE_DIGITS are stored front to back, then the
+ * limbs are reversed and shifted by the digits of the last, partial group.
+ */
 std::istream &operator>>(std::istream &is, Bint &b)
 {
-	std::string s;
-	is >> s;
-	b = Bint(s);
+	std::istream::sentry sentry(is);
+	if (!sentry) {
+		return is;
+	}
+	const std::ctype<char> &ctype = std::use_facet<std::ctype<char>>(is.getloc());
+	std::streambuf *buf = is.rdbuf();
+	int c = buf->sgetc();
+	bool minus = false;
+	for (; c == '-'; c = buf->snextc()) {
+		minus = !minus;
+	}
+	// groups collect on the stack and move to b once, at the end or when
+	// they outgrow it, so a value takes one allocation at most
+	const size_t STACK_GROUPS = 64;
+	BintKernel::limb stackGroups[STACK_GROUPS];
+	BintKernel::limb *groups = stackGroups, group = 0;
+	size_t count = 0, room = STACK_GROUPS;
+	int groupDigits = 0;
+	for (;; c = buf->snextc()) {
+		unsigned digit = static_cast<unsigned>(c - '0');
+		if (digit > 9) {
+			if (c == std::char_traits<char>::eof()) {
+				is.setstate(std::ios::eofbit);
+				break;
+			}
+			if (ctype.is(std::ctype_base::space, static_cast<char>(c))) {
+				break;
+			}
+			b = 0;
+			throw Bint::BadCast();
+		}
+		group = group * 10 + static_cast<BintKernel::limb>(digit);
+		if (++groupDigits == BintKernel::BASE_DIGITS) {
+			if (count == room) {
+				if (groups == stackGroups) {
+					b._Reserve(2 * STACK_GROUPS);
+					memcpy(b.data, stackGroups, sizeof(stackGroups));
+				} else {
+					b.length = count;
+					b._DoubleSpace();
+				}
+				groups = b.data;
+				room = b.capacity;
+			}
+			groups[count++] = group;
+			group = 0;
+			groupDigits = 0;
+		}
+	}
+	if (groups == stackGroups) {
+		b._Reserve(count + 1);
+		memcpy(b.data, stackGroups, count * sizeof(BintKernel::limb));
+	}
+	b.length = count;
+	std::reverse(b.data, b.data + b.length);
+	unsigned long long carry = group, scale = 1;
+	for (int i = 0; i < groupDigits; ++i) {
+		scale *= 10;
+	}
+	for (size_t i = 0; i < b.length; ++i) {
+		unsigned long long t = static_cast<unsigned long long>(b.data[i]) * scale + carry;
+		b.data[i] = static_cast<BintKernel::limb>(t % BintKernel::BASE);
+		carry = t / BintKernel::BASE;
+	}
+	if (carry != 0 || b.length == 0) {
+		if (b.length == b.capacity) {
+			b._DoubleSpace();
+		}
+		b.data[b.length++] = static_cast<BintKernel::limb>(carry);
+	}
+	b.isMinus = minus;
+	b._Trim();
 	return is;
 }
 
+size_t Bint::bufferSize() const
+{
+	return length * BintKernel::BASE_DIGITS + 1;
+}
+
+char *Bint::toChars(char *out) const
+{
+	if (isMinus) {
+		*out++ = '-';
+	}
+	out = BintKernel::formatDigits(data[length - 1], out);
+	for (size_t i = length - 1; i-- > 0;) {
+		BintKernel::formatLimb(data[i], out);
+		out += BintKernel::BASE_DIGITS;
+	}
+	return out;
+}
+
+// formats into a stack buffer for the common short values and pads to the
+// stream width as a string would be
 std::ostream &operator<<(std::ostream &os, const Bint &b)
 {
-	if (b.data == nullptr) {
-		return os;
+	const size_t STACK_CHARS = 256;
+	char stackBuffer[STACK_CHARS];
+	std::vector<char> heapBuffer;
+	char *buffer = stackBuffer;
+	if (b.bufferSize() > STACK_CHARS) {
+		heapBuffer.resize(b.bufferSize());
+		buffer = heapBuffer.data();
 	}
-	if (b.isMinus && (b.length > 1 || b.data[0] != 0)) {
-		os << "-";
+	std::streamsize count = b.toChars(buffer) - buffer, padding = std::max<std::streamsize>(0, os.width() - count);
+	bool left = (os.flags() & std::ios::adjustfield) == std::ios::left;
+	os.width(0);
+	if (!left) {
+		for (std::streamsize i = 0; i < padding; ++i) {
+			os.put(os.fill());
+		}
 	}
-	os << b.data[b.length - 1];
-	for (long long i = b.length - 2LL; i >= 0; --i) {
-		os << std::setw(4) << std::setfill('0') << b.data[i];
+	os.write(buffer, count);
+	if (left) {
+		for (std::streamsize i = 0; i < padding; ++i) {
+			os.put(os.fill());
+		}
 	}
 	return os;
 }
@@ -287,230 +854,1438 @@ Bint abs(const Bint &b)
 Bint abs(Bint &&b)
 {
 	b.isMinus = false;
-	return b;
+	return std::move(b);
 }
 
-bool operator==(const Bint &lhs, const Bint &rhs)
+// sign of lhs - rhs
+int Bint::_Compare(const Bint &lhs, const Bint &rhs)
 {
 	if (lhs.isMinus != rhs.isMinus) {
-		return false;
+		return lhs.isMinus ? -1 : 1;
 	}
-	if (lhs.length != rhs.length) {
-		return false;
-	}
-	for (size_t i = 0; i < lhs.length; ++i) {
-		if (lhs.data[i] != rhs.data[i]) {
-			return false;
-		}
-	}
-	return true;
+	int c = BintKernel::compareLimbs(lhs.data, lhs.length, rhs.data, rhs.length);
+	return lhs.isMinus ? -c : c;
+}
+
+bool operator==(const Bint &lhs, const Bint &rhs)
+{
+	return lhs.isMinus == rhs.isMinus && lhs.length == rhs.length &&
+	       memcmp(lhs.data, rhs.data, lhs.length * sizeof(BintKernel::limb)) == 0;
 }
 
 bool operator!=(const Bint &lhs, const Bint &rhs)
 {
-	if (lhs.isMinus != rhs.isMinus) {
-		return true;
-	}
-	if (lhs.length != rhs.length) {
-		return true;
-	}
-	for (size_t i = 0; i < lhs.length; ++i) {
-		if (lhs.data[i] != rhs.data[i]) {
-			return true;
-		}
-	}
-	return false;
+	return !(lhs == rhs);
 }
 
 bool operator<(const Bint &lhs, const Bint &rhs)
 {
-	if (lhs.isMinus != rhs.isMinus) {
-		return !lhs.isMinus;
-	}
-	if (lhs.isMinus) {
-		if (lhs.length != rhs.length) {
-			return lhs.length > rhs.length;
-		}
-		for (long long i = lhs.length - 1; i >= 0; --i) {
-			if (lhs.data[i] != rhs.data[i]) {
-				return lhs.data[i] > rhs.data[i];
-			}
-		}
-		return false;
-	} else {
-		if (lhs.length != rhs.length) {
-			return lhs.length < rhs.length;
-		}
-		for (long long i = lhs.length - 1; i >= 0; --i) {
-			if (lhs.data[i] != rhs.data[i]) {
-				return lhs.data[i] < rhs.data[i];
-			}
-		}
-		return false;
-	}
+	return Bint::_Compare(lhs, rhs) < 0;
 }
 
 bool operator>(const Bint &lhs, const Bint &rhs)
 {
-	return rhs < lhs;
+	return Bint::_Compare(lhs, rhs) > 0;
 }
 
 bool operator<=(const Bint &lhs, const Bint &rhs)
 {
-	if (lhs.isMinus != rhs.isMinus) {
-		return !lhs.isMinus;
-	}
-	if (lhs.isMinus) {
-		if (lhs.length != rhs.length) {
-			return lhs.length > rhs.length;
-		}
-		for (long long i = lhs.length - 1; i >= 0; --i) {
-			if (lhs.data[i] != rhs.data[i]) {
-				return lhs.data[i] > rhs.data[i];
-			}
-		}
-		return true;
-	} else {
-		if (lhs.length != rhs.length) {
-			return lhs.length < rhs.length;
-		}
-		for (long long i = lhs.length - 1; i >= 0; --i) {
-			if (lhs.data[i] != rhs.data[i]) {
-				return lhs.data[i] < rhs.data[i];
-			}
+	return Bint::_Compare(lhs, rhs) <= 0;
+}
+
+bool operator>=(const Bint &lhs, const Bint &rhs)
+{
+	return Bint::_Compare(lhs, rhs) >= 0;
+}
+
+
+namespace BintKernel {
+
+/*
+ * Carry and comparison kernels. The vector versions resolve the carries of
+ * a block of lanes at once: a lane whose sum is above BASE - 1 generates a
+ * carry and one equal to it propagates one, so with G and P the lane
+ * bitmasks the carries into the lanes are (P + (2G | carry in)) ^ P, the
+ * same ripple a binary adder runs through P, and the bit above the top
+ * lane is the carry out. Borrows work the same way with negative and zero
+ * differences.
+ */
+#ifdef UTIL_BINT_SIMD_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+namespace avx2 {
+
+// -1 in the lanes whose bit is set in mask
+inline __m256i laneMask(unsigned mask)
+{
+	const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)), bits), bits);
+}
+
+inline unsigned laneBits(__m256i v)
+{
+	return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(v)));
+}
+
+// n a multiple of 8
+limb addCarry(const limb *a, const limb *b, limb *r, size_t n, limb carry)
+{
+	const __m256i top = _mm256_set1_epi32(BASE - 1), base = _mm256_set1_epi32(BASE);
+	for (size_t i = 0; i < n; i += 8) {
+		__m256i s = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+		                             _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+		unsigned g = laneBits(_mm256_cmpgt_epi32(s, top)), p = laneBits(_mm256_cmpeq_epi32(s, top));
+		unsigned ripple = p + (g << 1 | static_cast<unsigned>(carry));
+		carry = static_cast<limb>(ripple >> 8);
+		s = _mm256_sub_epi32(s, laneMask((ripple ^ p) & 0xff));
+		s = _mm256_sub_epi32(s, _mm256_and_si256(_mm256_cmpgt_epi32(s, top), base));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), s);
+	}
+	return carry;
+}
+
+limb subBorrow(const limb *a, const limb *b, limb *r, size_t n, limb borrow)
+{
+	const __m256i zero = _mm256_setzero_si256(), base = _mm256_set1_epi32(BASE);
+	for (size_t i = 0; i < n; i += 8) {
+		__m256i d = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+		                             _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+		unsigned g = laneBits(_mm256_cmpgt_epi32(zero, d)), p = laneBits(_mm256_cmpeq_epi32(d, zero));
+		unsigned ripple = p + (g << 1 | static_cast<unsigned>(borrow));
+		borrow = static_cast<limb>(ripple >> 8);
+		d = _mm256_add_epi32(d, laneMask((ripple ^ p) & 0xff));
+		d = _mm256_add_epi32(d, _mm256_and_si256(_mm256_cmpgt_epi32(zero, d), base));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), d);
+	}
+	return borrow;
+}
+
+// the highest index below n, a multiple of 8, where a and b differ, or n
+size_t highestDifference(const limb *a, const limb *b, size_t n)
+{
+	for (size_t i = n; i > 0; i -= 8) {
+		__m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i - 8)),
+		                                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i - 8)));
+		unsigned differ = ~laneBits(eq) & 0xff;
+		if (differ != 0) {
+			return i - 8 + (31 - __builtin_clz(differ));
 		}
-		return true;
 	}
+	return n;
 }
 
-bool operator>=(const Bint &lhs, const Bint &rhs)
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+
+namespace sse42 {
+
+inline __m128i laneMask(unsigned mask)
 {
-	if (lhs.isMinus != rhs.isMinus) {
-		return lhs.isMinus;
+	const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+	return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(mask)), bits), bits);
+}
+
+inline unsigned laneBits(__m128i v)
+{
+	return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(v)));
+}
+
+// n a multiple of 4
+limb addCarry(const limb *a, const limb *b, limb *r, size_t n, limb carry)
+{
+	const __m128i top = _mm_set1_epi32(BASE - 1), base = _mm_set1_epi32(BASE);
+	for (size_t i = 0; i < n; i += 4) {
+		__m128i s = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+		                          _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+		unsigned g = laneBits(_mm_cmpgt_epi32(s, top)), p = laneBits(_mm_cmpeq_epi32(s, top));
+		unsigned ripple = p + (g << 1 | static_cast<unsigned>(carry));
+		carry = static_cast<limb>(ripple >> 4);
+		s = _mm_sub_epi32(s, laneMask((ripple ^ p) & 0xf));
+		s = _mm_sub_epi32(s, _mm_and_si128(_mm_cmpgt_epi32(s, top), base));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(r + i), s);
+	}
+	return carry;
+}
+
+limb subBorrow(const limb *a, const limb *b, limb *r, size_t n, limb borrow)
+{
+	const __m128i zero = _mm_setzero_si128(), base = _mm_set1_epi32(BASE);
+	for (size_t i = 0; i < n; i += 4) {
+		__m128i d = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+		                          _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+		unsigned g = laneBits(_mm_cmpgt_epi32(zero, d)), p = laneBits(_mm_cmpeq_epi32(d, zero));
+		unsigned ripple = p + (g << 1 | static_cast<unsigned>(borrow));
+		borrow = static_cast<limb>(ripple >> 4);
+		d = _mm_add_epi32(d, laneMask((ripple ^ p) & 0xf));
+		d = _mm_add_epi32(d, _mm_and_si128(_mm_cmpgt_epi32(zero, d), base));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(r + i), d);
+	}
+	return borrow;
+}
+
+size_t highestDifference(const limb *a, const limb *b, size_t n)
+{
+	for (size_t i = n; i > 0; i -= 4) {
+		__m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i - 4)),
+		                             _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i - 4)));
+		unsigned differ = ~laneBits(eq) & 0xf;
+		if (differ != 0) {
+			return i - 4 + (31 - __builtin_clz(differ));
+		}
+	}
+	return n;
+}
+
+}
+
+#pragma GCC pop_options
+
+#endif
+
+SimdLevel simdDetected()
+{
+#ifdef UTIL_BINT_SIMD_X86
+	static const SimdLevel best = __builtin_cpu_supports("avx2") ? AVX2 :
+	                              __builtin_cpu_supports("sse4.2") ? SSE42 : Scalar;
+	return best;
+#else
+	return Scalar;
+#endif
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+	return level == AVX2 ? "avx2" : level == SSE42 ? "sse4.2" : "scalar";
+}
+
+// shorter runs stay scalar: the dispatch costs more than the vector saves
+const size_t SIMD_MIN_LIMBS = 8;
+
+limb addCarry(const limb *a, const limb *b, limb *r, size_t n, limb carry, SimdLevel level)
+{
+	size_t i = 0;
+#ifdef UTIL_BINT_SIMD_X86
+	level = std::min(level, simdDetected());
+	if (level == AVX2) {
+		i = n & ~size_t(7);
+		carry = avx2::addCarry(a, b, r, i, carry);
+	} else if (level == SSE42) {
+		i = n & ~size_t(3);
+		carry = sse42::addCarry(a, b, r, i, carry);
+	}
+#else
+	(void)level;
+#endif
+	for (; i < n; ++i) {
+		limb t = a[i] + b[i] + carry;
+		carry = t >= BASE;
+		r[i] = carry ? t - BASE : t;
+	}
+	return carry;
+}
+
+limb addCarry(const limb *a, const limb *b, limb *r, size_t n, limb carry)
+{
+	return addCarry(a, b, r, n, carry, n < SIMD_MIN_LIMBS ? Scalar : simdDetected());
+}
+
+limb subBorrow(const limb *a, const limb *b, limb *r, size_t n, limb borrow, SimdLevel level)
+{
+	size_t i = 0;
+#ifdef UTIL_BINT_SIMD_X86
+	level = std::min(level, simdDetected());
+	if (level == AVX2) {
+		i = n & ~size_t(7);
+		borrow = avx2::subBorrow(a, b, r, i, borrow);
+	} else if (level == SSE42) {
+		i = n & ~size_t(3);
+		borrow = sse42::subBorrow(a, b, r, i, borrow);
+	}
+#else
+	(void)level;
+#endif
+	for (; i < n; ++i) {
+		limb t = a[i] - b[i] - borrow;
+		borrow = t < 0;
+		r[i] = borrow ? t + BASE : t;
+	}
+	return borrow;
+}
+
+limb subBorrow(const limb *a, const limb *b, limb *r, size_t n, limb borrow)
+{
+	return subBorrow(a, b, r, n, borrow, n < SIMD_MIN_LIMBS ? Scalar : simdDetected());
+}
+
+int compareLimbs(const limb *a, size_t n, const limb *b, size_t m, SimdLevel level)
+{
+	if (n != m) {
+		return n < m ? -1 : 1;
+	}
+	// the vector part covers the top limbs, the scalar loop what is left
+	// at the bottom
+	size_t i = n;
+#ifdef UTIL_BINT_SIMD_X86
+	level = std::min(level, simdDetected());
+	size_t rest = level == AVX2 ? n % 8 : level == SSE42 ? n % 4 : n;
+	if (rest != n) {
+		size_t k = level == AVX2 ? avx2::highestDifference(a + rest, b + rest, n - rest) :
+		           sse42::highestDifference(a + rest, b + rest, n - rest);
+		if (k != n - rest) {
+			return a[rest + k] < b[rest + k] ? -1 : 1;
+		}
+		i = rest;
 	}
-	if (lhs.isMinus) {
-		if (lhs.length != rhs.length) {
-			return lhs.length < rhs.length;
+#else
+	(void)level;
+#endif
+	while (i-- > 0) {
+		if (a[i] != b[i]) {
+			return a[i] < b[i] ? -1 : 1;
 		}
-		for (long long i = lhs.length - 1; i >= 0; --i) {
-			if (lhs.data[i] != rhs.data[i]) {
-				return lhs.data[i] < rhs.data[i];
+	}
+	return 0;
+}
+
+int compareLimbs(const limb *a, size_t n, const limb *b, size_t m)
+{
+	return compareLimbs(a, n, b, m, n < SIMD_MIN_LIMBS ? Scalar : simdDetected());
+}
+
+void mulSchoolbook(const limb *a, size_t n, const limb *b, size_t m, limb *r)
+{
+	// products are below BASE^2 < 2^60, so a column normalized below BASE
+	// (plus a small carry) takes ROWS_PER_CARRY more of them in 64 bits;
+	// the columns a block of that many rows touched are carried after it
+	const size_t ROWS_PER_CARRY = 16;
+	const size_t STACK_COLUMNS = 4 * KARATSUBA_THRESHOLD;
+	unsigned long long stackColumns[STACK_COLUMNS];
+	std::vector<unsigned long long> heapColumns;
+	unsigned long long *column = stackColumns;
+	if (n + m > STACK_COLUMNS) {
+		heapColumns.assign(n + m, 0);
+		column = heapColumns.data();
+	} else {
+		memset(column, 0, (n + m) * sizeof(unsigned long long));
+	}
+	for (size_t first = 0; first < n; first += ROWS_PER_CARRY) {
+		size_t last = std::min(n, first + ROWS_PER_CARRY);
+		for (size_t i = first; i < last; ++i) {
+			unsigned long long x = static_cast<unsigned long long>(a[i]);
+			if (x == 0) {
+				continue;
+			}
+			unsigned long long *out = column + i;
+			for (size_t j = 0; j < m; ++j) {
+				out[j] += x * static_cast<unsigned long long>(b[j]);
 			}
 		}
-		return true;
+		if (last == n) {
+			break;
+		}
+		unsigned long long carry = 0;
+		for (size_t k = first; k < last + m - 1; ++k) {
+			unsigned long long t = column[k] + carry;
+			column[k] = t % BASE;
+			carry = t / BASE;
+		}
+		column[last + m - 1] += carry;
+	}
+	unsigned long long carry = 0;
+	for (size_t k = 0; k < n + m; ++k) {
+		unsigned long long t = column[k] + carry;
+		r[k] = static_cast<limb>(t % BASE);
+		carry = t / BASE;
+	}
+}
+
+// r[0, n] = a[0, n) + b[0, m), n >= m
+void addLimbs(const limb *a, size_t n, const limb *b, size_t m, limb *r)
+{
+	limb carry = addCarry(a, b, r, m, 0);
+	for (size_t i = m; i < n; ++i) {
+		limb t = a[i] + carry;
+		carry = t >= BASE;
+		r[i] = carry ? t - BASE : t;
+	}
+	r[n] = carry;
+}
+
+// a[0, n) += b[0, m), n >= m; returns the carry out of a[n - 1]
+limb addInPlace(limb *a, size_t n, const limb *b, size_t m)
+{
+	limb carry = addCarry(a, b, a, m, 0);
+	for (size_t i = m; carry && i < n; ++i) {
+		carry = ++a[i] == BASE;
+		if (carry) {
+			a[i] = 0;
+		}
+	}
+	return carry;
+}
+
+// a[0, n) = b[0, n) - a[0, n), b >= a
+void subFrom(limb *a, const limb *b, size_t n)
+{
+	subBorrow(b, a, a, n, 0);
+}
+
+// a[0, n) -= b[0, m), n >= m, a >= b
+void subInPlace(limb *a, size_t n, const limb *b, size_t m)
+{
+	limb borrow = subBorrow(a, b, a, m, 0);
+	for (size_t i = m; borrow && i < n; ++i) {
+		borrow = --a[i] < 0;
+		if (borrow) {
+			a[i] += BASE;
+		}
+	}
+}
+
+size_t trimmed(const limb *a, size_t n)
+{
+	while (n > 0 && a[n - 1] == 0) {
+		--n;
+	}
+	return n;
+}
+
+// scratch limbs mulRec may use for operands of up to n limbs
+size_t scratchSize(size_t n)
+{
+	return 6 * n + 512;
+}
+
+void karatsuba(const limb *a, size_t n, const limb *b, size_t m, limb *r, limb *scratch);
+void toom3(const limb *a, size_t n, const limb *b, size_t m, limb *r);
+void ntt(const limb *a, size_t n, const limb *b, size_t m, limb *r);
+
+void mulRec(const limb *a, size_t n, const limb *b, size_t m, limb *r, limb *scratch)
+{
+	if (n < m) {
+		std::swap(a, b);
+		std::swap(n, m);
+	}
+	if (m < KARATSUBA_THRESHOLD) {
+		mulSchoolbook(a, n, b, m, r);
+		return;
+	}
+	if (m >= NTT_THRESHOLD && n + m <= NTT_MAX_LENGTH) {
+		ntt(a, n, b, m, r);
+		return;
+	}
+	if (2 * m <= n + 1) {
+		// unbalanced: multiply b by slices of a of its own size
+		memset(r, 0, (n + m) * sizeof(limb));
+		limb *product = scratch;
+		for (size_t i = 0; i < n; i += m) {
+			size_t len = std::min(m, n - i);
+			mulRec(a + i, len, b, m, product, product + 2 * m);
+			addInPlace(r + i, n + m - i, product, len + m);
+		}
+		return;
+	}
+	if (m >= TOOM3_THRESHOLD) {
+		toom3(a, n, b, m, r);
+		return;
+	}
+	karatsuba(a, n, b, m, r, scratch);
+}
+
+/*
+ * n >= m > h = ceil(n / 2): with x = BASE^h, a = a1 x + a0, b = b1 x + b0,
+ * ab = z2 x^2 + ((a0 + a1)(b0 + b1) - z0 - z2) x + z0.
+ * z0 and z2 land directly in r; the middle term is formed in scratch and
+ * added with a single carry pass.
+ */
+void karatsuba(const limb *a, size_t n, const limb *b, size_t m, limb *r, limb *scratch)
+{
+	size_t h = (n + 1) / 2;
+	mulRec(a, h, b, h, r, scratch);
+	mulRec(a + h, n - h, b + h, m - h, r + 2 * h, scratch);
+	limb *sa = scratch, *sb = sa + h + 1, *z1 = sb + h + 1;
+	addLimbs(a, h, a + h, n - h, sa);
+	addLimbs(b, h, b + h, m - h, sb);
+	mulRec(sa, h + 1, sb, h + 1, z1, z1 + 2 * h + 2);
+	subInPlace(z1, 2 * h + 2, r, 2 * h);
+	subInPlace(z1, 2 * h + 2, r + 2 * h, n + m - 2 * h);
+	addInPlace(r + h, n + m - h, z1, trimmed(z1, 2 * h + 2));
+}
+
+/*
+ * signed numbers for the Toom-3 evaluation and interpolation:
+ * a trimmed magnitude and a sign.
+ */
+struct Signed {
+	std::vector<limb> mag;
+	bool minus = false;
+};
+
+Signed slice(const limb *a, size_t n, size_t from, size_t len)
+{
+	Signed x;
+	if (from < n) {
+		x.mag.assign(a + from, a + std::min(n, from + len));
+		x.mag.resize(trimmed(x.mag.data(), x.mag.size()));
+	}
+	return x;
+}
+
+int compareMag(const std::vector<limb> &a, const std::vector<limb> &b)
+{
+	return compareLimbs(a.data(), a.size(), b.data(), b.size());
+}
+
+Signed add(const Signed &x, const Signed &y, bool negateY = false)
+{
+	bool yMinus = y.minus != negateY;
+	Signed r;
+	if (x.minus == yMinus) {
+		const std::vector<limb> &big = x.mag.size() >= y.mag.size() ? x.mag : y.mag;
+		const std::vector<limb> &small = x.mag.size() >= y.mag.size() ? y.mag : x.mag;
+		r.mag.resize(big.size() + 1);
+		addLimbs(big.data(), big.size(), small.data(), small.size(), r.mag.data());
+		r.minus = x.minus;
 	} else {
-		if (lhs.length != rhs.length) {
-			return lhs.length > rhs.length;
+		int c = compareMag(x.mag, y.mag);
+		const Signed &big = c >= 0 ? x : y;
+		const Signed &small = c >= 0 ? y : x;
+		r.mag = big.mag;
+		subInPlace(r.mag.data(), r.mag.size(), small.mag.data(), small.mag.size());
+		r.minus = c >= 0 ? x.minus : yMinus;
+	}
+	r.mag.resize(trimmed(r.mag.data(), r.mag.size()));
+	if (r.mag.empty()) {
+		r.minus = false;
+	}
+	return r;
+}
+
+Signed sub(const Signed &x, const Signed &y)
+{
+	return add(x, y, true);
+}
+
+Signed mul(const Signed &x, const Signed &y)
+{
+	Signed r;
+	if (x.mag.empty() || y.mag.empty()) {
+		return r;
+	}
+	r.mag.resize(x.mag.size() + y.mag.size());
+	multiply(x.mag.data(), x.mag.size(), y.mag.data(), y.mag.size(), r.mag.data());
+	r.mag.resize(trimmed(r.mag.data(), r.mag.size()));
+	r.minus = x.minus != y.minus;
+	return r;
+}
+
+Signed mulSmall(const Signed &x, limb k)
+{
+	Signed r = x;
+	limb carry = 0;
+	for (size_t i = 0; i < r.mag.size(); ++i) {
+		long long t = static_cast<long long>(r.mag[i]) * k + carry;
+		r.mag[i] = static_cast<limb>(t % BASE);
+		carry = static_cast<limb>(t / BASE);
+	}
+	if (carry) {
+		r.mag.push_back(carry);
+	}
+	return r;
+}
+
+Signed divExact(const Signed &x, limb k)
+{
+	Signed r = x;
+	limb rest = 0;
+	for (size_t i = r.mag.size(); i-- > 0;) {
+		long long t = static_cast<long long>(rest) * BASE + r.mag[i];
+		r.mag[i] = static_cast<limb>(t / k);
+		rest = static_cast<limb>(t % k);
+	}
+	r.mag.resize(trimmed(r.mag.data(), r.mag.size()));
+	return r;
+}
+
+/*
+ * Toom-3 with k = ceil(n / 3) limbs per part: the parts are evaluated at
+ * 0, 1, -1, -2 and infinity, multiplied recursively, and the five
+ * coefficients recovered with Bodrato's interpolation sequence.
+ */
+void toom3(const limb *a, size_t n, const limb *b, size_t m, limb *r)
+{
+	size_t k = (n + 2) / 3;
+	Signed a0 = slice(a, n, 0, k), a1 = slice(a, n, k, k), a2 = slice(a, n, 2 * k, k);
+	Signed b0 = slice(b, m, 0, k), b1 = slice(b, m, k, k), b2 = slice(b, m, 2 * k, k);
+
+	Signed p = add(a0, a2), q = add(b0, b2);
+	Signed pm1 = sub(p, a1), qm1 = sub(q, b1);
+	Signed p1 = add(p, a1), q1 = add(q, b1);
+	Signed pm2 = sub(mulSmall(add(pm1, a2), 2), a0), qm2 = sub(mulSmall(add(qm1, b2), 2), b0);
+
+	Signed r0 = mul(a0, b0), r1 = mul(p1, q1), rm1 = mul(pm1, qm1), rm2 = mul(pm2, qm2), r4 = mul(a2, b2);
+
+	Signed r3 = divExact(sub(rm2, r1), 3);
+	r1 = divExact(sub(r1, rm1), 2);
+	Signed r2 = sub(rm1, r0);
+	r3 = add(divExact(sub(r2, r3), 2), mulSmall(r4, 2));
+	r2 = sub(add(r2, r1), r4);
+	r1 = sub(r1, r3);
+
+	memset(r, 0, (n + m) * sizeof(limb));
+	const Signed *coefficient[5] = {&r0, &r1, &r2, &r3, &r4};
+	for (size_t i = 0; i < 5; ++i) {
+		const std::vector<limb> &c = coefficient[i]->mag;
+		if (!c.empty()) {
+			addInPlace(r + i * k, n + m - i * k, c.data(), c.size());
 		}
-		for (long long i = lhs.length - 1; i >= 0; --i) {
-			if (lhs.data[i] != rhs.data[i]) {
-				return lhs.data[i] > rhs.data[i];
-			}
+	}
+}
+
+/*
+ * Convolution modulo the NTT primes P = c 2^k + 1 with primitive root 3.
+ * The forward transform is decimation in frequency and leaves its output
+ * in bit-reversed order; the inverse is decimation in time and takes it
+ * back, so no permutation pass is needed. Residues stay below P < 2^30.
+ */
+const unsigned NTT_PRIMES[3] = {998244353, 167772161, 469762049};
+const unsigned NTT_ROOT = 3;
+
+template<unsigned P>
+unsigned mulMod(unsigned x, unsigned y)
+{
+	return static_cast<unsigned>(static_cast<unsigned long long>(x) * y % P);
+}
+
+template<unsigned P>
+unsigned powMod(unsigned x, unsigned long long e)
+{
+	unsigned r = 1;
+	for (; e; e >>= 1, x = mulMod<P>(x, x)) {
+		if (e & 1) {
+			r = mulMod<P>(r, x);
 		}
-		return true;
 	}
+	return r;
 }
 
+// roots[len + j] = w^j for the primitive (2 len)-th root w, len < size
+template<unsigned P>
+void nttRoots(std::vector<unsigned> &roots, size_t size, bool inverse)
+{
+	roots.resize(size);
+	for (size_t len = 1; len < size; len *= 2) {
+		unsigned w = powMod<P>(NTT_ROOT, (P - 1) / (2 * len));
+		if (inverse) {
+			w = powMod<P>(w, P - 2);
+		}
+		roots[len] = 1;
+		for (size_t j = 1; j < len; ++j) {
+			roots[len + j] = mulMod<P>(roots[len + j - 1], w);
+		}
+	}
+}
 
-Bint operator+(const Bint &lhs, const Bint &rhs)
+template<unsigned P>
+void nttForward(unsigned *a, size_t size, const unsigned *roots)
 {
-	if (lhs.isMinus == rhs.isMinus) {
-		size_t maxLen = std::max(lhs.length, rhs.length);
-		size_t expectLen = maxLen + 1;
-		Bint result(expectLen); // special constructor
-		for (size_t i = 0; i < maxLen; ++i) {
-			result.data[i] = lhs.data[i] + rhs.data[i];
-		}
-		for (size_t i = 0; i < maxLen; ++i) {
-			if (result.data[i] > 10000) {
-				result.data[i] -= 10000;
-				++result.data[i + 1];
+	for (size_t len = size / 2; len >= 1; len /= 2) {
+		const unsigned *w = roots + len;
+		for (size_t i = 0; i < size; i += 2 * len) {
+			for (size_t j = 0; j < len; ++j) {
+				unsigned u = a[i + j], v = a[i + j + len];
+				unsigned s = u + v;
+				a[i + j] = s >= P ? s - P : s;
+				a[i + j + len] = mulMod<P>(u + P - v, w[j]);
 			}
 		}
-		result.length = result.data[maxLen] > 0 ? maxLen + 1 : maxLen;
-		result.isMinus = lhs.isMinus;
-		return result;
+	}
+}
+
+template<unsigned P>
+void nttInverse(unsigned *a, size_t size, const unsigned *roots)
+{
+	for (size_t len = 1; len < size; len *= 2) {
+		const unsigned *w = roots + len;
+		for (size_t i = 0; i < size; i += 2 * len) {
+			for (size_t j = 0; j < len; ++j) {
+				unsigned u = a[i + j], v = mulMod<P>(a[i + j + len], w[j]);
+				unsigned s = u + v;
+				a[i + j] = s >= P ? s - P : s;
+				a[i + j + len] = u >= v ? u - v : u + P - v;
+			}
+		}
+	}
+}
+
+// out[0, size) = a * b modulo P, cyclic of length size >= n + m - 1
+template<unsigned P>
+void convolution(const limb *a, size_t n, const limb *b, size_t m, size_t size, unsigned *out)
+{
+	std::vector<unsigned> roots, other;
+	nttRoots<P>(roots, size, false);
+	// limbs can exceed P, so they are reduced first
+	for (size_t i = 0; i < size; ++i) {
+		out[i] = i < n ? static_cast<unsigned>(a[i]) % P : 0;
+	}
+	nttForward<P>(out, size, roots.data());
+	if (a == b && n == m) {
+		for (size_t i = 0; i < size; ++i) {
+			out[i] = mulMod<P>(out[i], out[i]);
+		}
 	} else {
-		if (lhs.isMinus) {
-			return rhs - abs(lhs);
-		} else {
-			return lhs - abs(rhs);
+		other.resize(size);
+		for (size_t i = 0; i < size; ++i) {
+			other[i] = i < m ? static_cast<unsigned>(b[i]) % P : 0;
 		}
+		nttForward<P>(other.data(), size, roots.data());
+		for (size_t i = 0; i < size; ++i) {
+			out[i] = mulMod<P>(out[i], other[i]);
+		}
+	}
+	nttRoots<P>(roots, size, true);
+	nttInverse<P>(out, size, roots.data());
+	unsigned scale = powMod<P>(static_cast<unsigned>(size % P), P - 2);
+	for (size_t i = 0; i < size; ++i) {
+		out[i] = mulMod<P>(out[i], scale);
 	}
 }
 
-Bint operator-(const Bint &b)
+/*
+ * Every coefficient of the product is below min(n, m) (BASE - 1)^2 <=
+ * 2^22 10^18, under the product of the three primes (about 7.8 10^25), so
+ * Garner's algorithm rebuilds it exactly from its residues. It has at
+ * most 88 bits and is carried into base BASE with 64-bit divisions.
+ */
+void ntt(const limb *a, size_t n, const limb *b, size_t m, limb *r)
 {
-	Bint result(b);
-	result.isMinus = !result.isMinus;
-	return result;
+	const unsigned long long P0 = NTT_PRIMES[0], P1 = NTT_PRIMES[1], P2 = NTT_PRIMES[2];
+	size_t size = 1;
+	while (size < n + m - 1) {
+		size *= 2;
+	}
+	std::vector<unsigned> r0(size), r1(size), r2(size);
+	convolution<998244353>(a, n, b, m, size, r0.data());
+	convolution<167772161>(a, n, b, m, size, r1.data());
+	convolution<469762049>(a, n, b, m, size, r2.data());
+	const unsigned inv01 = powMod<167772161>(static_cast<unsigned>(P0 % P1), P1 - 2);
+	const unsigned inv012 = powMod<469762049>(static_cast<unsigned>(P0 * P1 % P2), P2 - 2);
+	unsigned long long carry = 0;
+	for (size_t k = 0; k < n + m; ++k) {
+		unsigned __int128 t = carry;
+		if (k < n + m - 1) {
+			unsigned v1 = mulMod<167772161>(static_cast<unsigned>((r1[k] + P1 - r0[k] % P1) % P1), inv01);
+			unsigned long long low = r0[k] + P0 * v1;
+			unsigned v2 = mulMod<469762049>(static_cast<unsigned>((r2[k] + P2 - low % P2) % P2), inv012);
+			t += low + static_cast<unsigned __int128>(P0 * P1) * v2;
+		}
+		// t < 2^89: long division by BASE in 32-bit digits, the top one
+		// (below 2^25) being already smaller than BASE
+		unsigned long long high = static_cast<unsigned long long>(t >> 64);
+		unsigned long long low = static_cast<unsigned long long>(t);
+		unsigned long long mid = high << 32 | low >> 32;
+		unsigned long long bottom = (mid % BASE) << 32 | (low & 0xffffffffULL);
+		r[k] = static_cast<limb>(bottom % BASE);
+		carry = (mid / BASE) << 32 | bottom / BASE;
+	}
 }
 
-Bint operator-(Bint &&b)
+void mulKaratsuba(const limb *a, size_t n, const limb *b, size_t m, limb *r)
 {
-	b.isMinus = !b.isMinus;
-	return b;
+	if (n < m) {
+		std::swap(a, b);
+		std::swap(n, m);
+	}
+	if (m == 0 || 2 * m <= n + 1) {
+		multiply(a, n, b, m, r);
+		return;
+	}
+	std::vector<limb> scratch(scratchSize(n));
+	karatsuba(a, n, b, m, r, scratch.data());
 }
 
-Bint operator-(const Bint &lhs, const Bint &rhs)
+void mulToom3(const limb *a, size_t n, const limb *b, size_t m, limb *r)
 {
-	if (lhs.isMinus == rhs.isMinus) {
-		if (lhs.isMinus) {
-			return -(abs(lhs) - abs(rhs));
-		} else {
-			if (lhs < rhs) {
-				return -(rhs - lhs);
-			}
-			Bint result(std::max(lhs.length, rhs.length));
-			for (size_t i = 0; i < lhs.length; ++i) {
-				result.data[i] = lhs.data[i] - rhs.data[i];
+	if (n < m) {
+		std::swap(a, b);
+		std::swap(n, m);
+	}
+	if (m < 3 || 2 * m <= n + 1) {
+		multiply(a, n, b, m, r);
+		return;
+	}
+	toom3(a, n, b, m, r);
+}
+
+void mulNtt(const limb *a, size_t n, const limb *b, size_t m, limb *r)
+{
+	if (n == 0 || m == 0 || n + m > NTT_MAX_LENGTH) {
+		multiply(a, n, b, m, r);
+		return;
+	}
+	ntt(a, n, b, m, r);
+}
+
+void multiply(const limb *a, size_t n, const limb *b, size_t m, limb *r)
+{
+	if (n == 0 || m == 0) {
+		memset(r, 0, (n + m) * sizeof(limb));
+		return;
+	}
+	if (std::min(n, m) < KARATSUBA_THRESHOLD) {
+		mulSchoolbook(a, n, b, m, r);
+		return;
+	}
+	std::vector<limb> scratch(scratchSize(std::max(n, m)));
+	mulRec(a, n, b, m, r, scratch.data());
+}
+
+// r[0, n] = a[0, n) * k, k < BASE
+void mulLimb(const limb *a, size_t n, limb k, limb *r)
+{
+	unsigned long long carry = 0;
+	for (size_t i = 0; i < n; ++i) {
+		unsigned long long t = static_cast<unsigned long long>(a[i]) * k + carry;
+		r[i] = static_cast<limb>(t % BASE);
+		carry = t / BASE;
+	}
+	r[n] = static_cast<limb>(carry);
+}
+
+// q[0, n) = a[0, n) / k; returns a % k
+limb divLimb(const limb *a, size_t n, limb k, limb *q)
+{
+	unsigned long long rest = 0;
+	for (size_t i = n; i-- > 0;) {
+		unsigned long long t = rest * BASE + static_cast<unsigned long long>(a[i]);
+		q[i] = static_cast<limb>(t / k);
+		rest = t % k;
+	}
+	return static_cast<limb>(rest);
+}
+
+// multiplier that brings the top limb of a divisor to at least BASE / 2
+limb normalizer(limb top)
+{
+	return BASE / (top + 1);
+}
+
+/*
+ * Knuth's algorithm D on u[0, n + m] by v[0, m), m >= 2, v already
+ * normalized and u[n + m] small enough for an (n + 1)-limb quotient: each
+ * quotient limb is guessed from the top two limbs of the
+ * running remainder and the top limb of v, refined with the next limb of
+ * v, and corrected by one add-back in the rare case it is still one too
+ * large. The quotient goes to q[0, n], the remainder stays in u[0, m).
+ */
+void knuthD(limb *u, size_t n, const limb *v, size_t m, limb *q)
+{
+	unsigned long long vTop = static_cast<unsigned long long>(v[m - 1]);
+	unsigned long long vNext = static_cast<unsigned long long>(v[m - 2]);
+	for (size_t j = n + 1; j-- > 0;) {
+		unsigned long long top = static_cast<unsigned long long>(u[j + m]) * BASE + u[j + m - 1];
+		unsigned long long qhat = top / vTop, rhat = top % vTop;
+		while (rhat < BASE && (qhat >= BASE || qhat * vNext > rhat * BASE + u[j + m - 2])) {
+			--qhat;
+			rhat += vTop;
+		}
+		unsigned long long carry = 0;
+		long long borrow = 0;
+		for (size_t i = 0; i < m; ++i) {
+			unsigned long long p = qhat * v[i] + carry;
+			carry = p / BASE;
+			long long t = static_cast<long long>(u[i + j]) - static_cast<long long>(p % BASE) - borrow;
+			borrow = t < 0;
+			u[i + j] = static_cast<limb>(borrow ? t + BASE : t);
+		}
+		long long t = static_cast<long long>(u[j + m]) - static_cast<long long>(carry) - borrow;
+		if (t < 0) {
+			--qhat;
+			limb c = 0;
+			for (size_t i = 0; i < m; ++i) {
+				limb s = u[i + j] + v[i] + c;
+				c = s >= BASE;
+				u[i + j] = c ? s - BASE : s;
 			}
-			for (size_t i = 0; i < lhs.length; ++i) {
-				if (result.data[i] < 0) {
-					result.data[i] += 10000;
-					++result.data[i + 1];
+			t += c;
+		}
+		u[j + m] = static_cast<limb>(t);
+		q[j] = static_cast<limb>(qhat);
+	}
+}
+
+/*
+ * Burnikel-Ziegler on normalized operands: a 2n / n division splits into
+ * two 3h / 2h divisions (h = n / 2), each of which divides its top 2h
+ * limbs by the top h limbs of the divisor recursively and fixes the guess
+ * with one product and at most two add-backs. Odd or short blocks go to
+ * Knuth's algorithm.
+ */
+void div2n1n(const limb *a, const limb *b, size_t n, limb *q, limb *r);
+
+// q[0, h), r[0, 2h) from a[0, 3h) by b[0, 2h), a < b * BASE^h
+void div3n2n(const limb *a, const limb *b, size_t h, limb *q, limb *r)
+{
+	Signed rest;
+	if (compareLimbs(a + 2 * h, h, b + h, h) < 0) {
+		std::vector<limb> r1(h);
+		div2n1n(a + h, b + h, h, q, r1.data());
+		rest.mag.assign(a, a + h);
+		rest.mag.insert(rest.mag.end(), r1.begin(), r1.end());
+	} else {
+		// the top limbs are equal, so the quotient is BASE^h - 1 at most
+		// and [a1 a2] - q b1 = a2 + b1
+		std::fill(q, q + h, BASE - 1);
+		rest.mag.assign(a, a + 2 * h);
+		rest.mag.push_back(addInPlace(rest.mag.data() + h, h, b + h, h));
+	}
+	rest.mag.resize(trimmed(rest.mag.data(), rest.mag.size()));
+	rest = sub(rest, mul(slice(q, h, 0, h), slice(b, 2 * h, 0, h)));
+	Signed divisor = slice(b, 2 * h, 0, 2 * h);
+	while (rest.minus) {
+		rest = add(rest, divisor);
+		for (size_t i = 0; q[i]-- == 0; ++i) {
+			q[i] = BASE - 1;
+		}
+	}
+	memset(r, 0, 2 * h * sizeof(limb));
+	std::copy(rest.mag.begin(), rest.mag.end(), r);
+}
+
+// q[0, n), r[0, n) from a[0, 2n) by b[0, n), a < b * BASE^n
+void div2n1n(const limb *a, const limb *b, size_t n, limb *q, limb *r)
+{
+	if (n % 2 || n < DIV_RECURSIVE_THRESHOLD) {
+		std::vector<limb> u(a, a + 2 * n), quotient(n + 1);
+		u.push_back(0);
+		knuthD(u.data(), n, b, n, quotient.data());
+		std::copy(quotient.begin(), quotient.begin() + n, q);
+		std::copy(u.begin(), u.begin() + n, r);
+		return;
+	}
+	size_t h = n / 2;
+	std::vector<limb> t(3 * h);
+	div3n2n(a + h, b, h, q + h, t.data() + h);
+	std::copy(a, a + h, t.begin());
+	div3n2n(t.data(), b, h, q, r);
+}
+
+void burnikelZiegler(const limb *a, size_t n, const limb *b, size_t m, limb *q, limb *r)
+{
+	// blocks of j * 2^k >= m limbs, j < DIV_RECURSIVE_THRESHOLD, so the
+	// recursion halves them down to Knuth-sized pieces
+	size_t pow2 = 1;
+	while (pow2 <= m / DIV_RECURSIVE_THRESHOLD) {
+		pow2 <<= 1;
+	}
+	size_t block = (m + pow2 - 1) / pow2 * pow2;
+	size_t shift = block - m;
+	limb d = normalizer(b[m - 1]);
+	std::vector<limb> v(block + 1), u(shift + n + 1);
+	mulLimb(b, m, d, v.data() + shift);
+	mulLimb(a, n, d, u.data() + shift);
+	// one spare limb on top keeps the leading block below v
+	size_t t = std::max<size_t>(2, trimmed(u.data(), u.size()) / block + 1);
+	u.resize(t * block);
+	memset(q, 0, (n - m + 1) * sizeof(limb));
+	std::vector<limb> z(u.end() - 2 * block, u.end()), qi(block), ri(block);
+	for (size_t i = t - 1; i-- > 0;) {
+		div2n1n(z.data(), v.data(), block, qi.data(), ri.data());
+		for (size_t k = 0; k < block && i * block + k < n - m + 1; ++k) {
+			q[i * block + k] = qi[k];
+		}
+		if (i > 0) {
+			std::copy(u.begin() + (i - 1) * block, u.begin() + i * block, z.begin());
+			std::copy(ri.begin(), ri.end(), z.begin() + block);
+		}
+	}
+	divLimb(ri.data() + shift, m, d, r);
+}
+
+void divKnuth(const limb *a, size_t n, const limb *b, size_t m, limb *q, limb *r)
+{
+	if (m == 1) {
+		r[0] = divLimb(a, n, b[0], q);
+		return;
+	}
+	limb d = normalizer(b[m - 1]);
+	std::vector<limb> u(n + 1), v(m + 1);
+	mulLimb(a, n, d, u.data());
+	mulLimb(b, m, d, v.data());
+	knuthD(u.data(), n - m, v.data(), m, q);
+	divLimb(u.data(), m, d, r);
+}
+
+void divBurnikelZiegler(const limb *a, size_t n, const limb *b, size_t m, limb *q, limb *r)
+{
+	if (m < 2) {
+		divKnuth(a, n, b, m, q, r);
+		return;
+	}
+	burnikelZiegler(a, n, b, m, q, r);
+}
+
+void divide(const limb *a, size_t n, const limb *b, size_t m, limb *q, limb *r)
+{
+	if (m < DIV_RECURSIVE_THRESHOLD || n - m < DIV_RECURSIVE_THRESHOLD) {
+		divKnuth(a, n, b, m, q, r);
+		return;
+	}
+	burnikelZiegler(a, n, b, m, q, r);
+}
+
+// a[0, len) * b[0, len) mod BASE^len
+std::vector<limb> mulLow(const limb *a, const limb *b, size_t len)
+{
+	std::vector<limb> r(2 * len);
+	multiply(a, len, b, len, r.data());
+	r.resize(len);
+	return r;
+}
+
+// a^-1 mod BASE, a coprime to BASE
+limb inverseModBase(limb a)
+{
+	long long r0 = BASE, r1 = a, s0 = 0, s1 = 1;
+	while (r1 != 0) {
+		long long t = r0 / r1;
+		r0 -= t * r1;
+		s0 -= t * s1;
+		std::swap(r0, r1);
+		std::swap(s0, s1);
+	}
+	return static_cast<limb>((s0 % BASE + BASE) % BASE);
+}
+
+/*
+ * Montgomery arithmetic modulo m[0, k), m coprime to BASE, with
+ * R = BASE^k: residues x are kept as xR mod m, and the product of two is
+ * brought back by reduce(t) = t / R mod m, which adds the multiple of m
+ * that clears the low k limbs instead of dividing. Below
+ * MONTGOMERY_PRODUCT_THRESHOLD limbs that multiple is built limb by limb
+ * from -m^-1 mod BASE; above it, from one low product with -m^-1 mod R, so
+ * the reduction costs two multiplications at the speed of multiply().
+ */
+struct Montgomery {
+	const limb *m;
+	size_t k;
+	limb mInv0;
+	std::vector<limb> mInv;
+	std::vector<limb> product, multiple;
+
+	Montgomery(const limb *m, size_t k)
+		: m(m), k(k), product(2 * k + 1), multiple(2 * k)
+	{
+		limb inv = inverseModBase(m[0]);
+		mInv0 = BASE - inv;
+		if (k < MONTGOMERY_PRODUCT_THRESHOLD) {
+			return;
+		}
+		// Newton's iteration x' = x (2 - m x) doubles the limbs of m^-1
+		// that are right each step
+		std::vector<limb> x(k), zero(k), two(1, 2);
+		x[0] = inv;
+		for (size_t p = 1; p < k;) {
+			p = std::min(2 * p, k);
+			std::vector<limb> e = mulLow(m, x.data(), p);
+			subFrom(e.data(), zero.data(), p);
+			addInPlace(e.data(), p, two.data(), 1);
+			std::vector<limb> next = mulLow(x.data(), e.data(), p);
+			std::copy(next.begin(), next.end(), x.begin());
+		}
+		subFrom(x.data(), zero.data(), k);
+		mInv = x;
+	}
+
+	// r[0, k) = t[0, 2k] / R mod m, t < mR; t is clobbered
+	void reduce(limb *t, limb *r)
+	{
+		if (k < MONTGOMERY_PRODUCT_THRESHOLD) {
+			for (size_t i = 0; i < k; ++i) {
+				unsigned long long u = static_cast<unsigned long long>(t[i]) * mInv0 % BASE;
+				unsigned long long carry = 0;
+				for (size_t j = 0; j < k; ++j) {
+					unsigned long long s = t[i + j] + u * m[j] + carry;
+					t[i + j] = static_cast<limb>(s % BASE);
+					carry = s / BASE;
+				}
+				for (size_t j = i + k; carry != 0; ++j) {
+					unsigned long long s = t[j] + carry;
+					t[j] = static_cast<limb>(s % BASE);
+					carry = s / BASE;
 				}
 			}
-			while (result.length > 1 && result.data[result.length - 1] == 0) {
-				--result.length;
+		} else {
+			std::vector<limb> u = mulLow(t, mInv.data(), k);
+			multiply(u.data(), k, m, k, multiple.data());
+			addInPlace(t, 2 * k + 1, multiple.data(), 2 * k);
+		}
+		// t / R < 2m
+		if (compareLimbs(t + k, trimmed(t + k, k + 1), m, k) >= 0) {
+			subInPlace(t + k, k + 1, m, k);
+		}
+		std::copy(t + k, t + 2 * k, r);
+	}
+
+	// r[0, k) = x y / R mod m
+	void mul(const limb *x, const limb *y, limb *r)
+	{
+		multiply(x, k, y, k, product.data());
+		product[2 * k] = 0;
+		reduce(product.data(), r);
+	}
+};
+
+/*
+ * r[0, k) = x^e mod m by left-to-right exponentiation in windows of
+ * POW_WINDOW bits; mulMod(x, y, r) multiplies two residues of k limbs
+ * into r, which overlaps neither, and one is the residue of 1.
+ */
+template<class MulMod>
+void powWindow(const limb *x, const limb *one, size_t k, const unsigned *e, size_t words, MulMod mulMod, limb *r)
+{
+	const size_t POW_WINDOW = 4;
+	std::vector<std::vector<limb>> table(size_t(1) << POW_WINDOW, std::vector<limb>(k));
+	std::copy(one, one + k, table[0].begin());
+	std::copy(x, x + k, table[1].begin());
+	for (size_t i = 2; i < table.size(); ++i) {
+		mulMod(table[i - 1].data(), x, table[i].data());
+	}
+	std::vector<limb> acc(one, one + k), next(k);
+	bool started = false;
+	for (size_t pos = (words * 32 + POW_WINDOW - 1) / POW_WINDOW * POW_WINDOW; pos > 0; pos -= POW_WINDOW) {
+		size_t digit = 0;
+		for (size_t bit = pos; bit-- > pos - POW_WINDOW;) {
+			digit = digit << 1 | (bit < words * 32 ? e[bit / 32] >> bit % 32 & 1 : 0);
+		}
+		if (started) {
+			for (size_t i = 0; i < POW_WINDOW; ++i) {
+				mulMod(acc.data(), acc.data(), next.data());
+				acc.swap(next);
 			}
-			return result;
+			if (digit != 0) {
+				mulMod(acc.data(), table[digit].data(), next.data());
+				acc.swap(next);
+			}
+		} else if (digit != 0) {
+			acc = table[digit];
+			started = true;
+		}
+	}
+	std::copy(acc.begin(), acc.end(), r);
+}
+
+void powModMontgomery(const limb *x, const limb *m, size_t k, const unsigned *e, size_t words, limb *r)
+{
+	// R mod m and xR mod m, by one division each
+	std::vector<limb> shifted(2 * k + 1), q(k + 2), one(k), xR(k);
+	shifted[k] = 1;
+	divide(shifted.data(), k + 1, m, k, q.data(), one.data());
+	std::fill(shifted.begin(), shifted.end(), 0);
+	std::copy(x, x + k, shifted.begin() + k);
+	divide(shifted.data(), 2 * k, m, k, q.data(), xR.data());
+	Montgomery mont(m, k);
+	std::vector<limb> result(k), t(2 * k + 1);
+	powWindow(xR.data(), one.data(), k, e, words, [&](const limb *a, const limb *b, limb *out) {
+		mont.mul(a, b, out);
+	}, result.data());
+	std::copy(result.begin(), result.end(), t.begin());
+	mont.reduce(t.data(), r);
+}
+
+void powModDivide(const limb *x, const limb *m, size_t k, const unsigned *e, size_t words, limb *r)
+{
+	std::vector<limb> one(k), product(2 * k), q(k + 1);
+	one[0] = k > 1 || m[0] > 1;
+	powWindow(x, one.data(), k, e, words, [&](const limb *a, const limb *b, limb *out) {
+		multiply(a, k, b, k, product.data());
+		size_t n = trimmed(product.data(), product.size());
+		if (n < k) {
+			std::copy(product.begin(), product.begin() + k, out);
+			return;
 		}
+		divide(product.data(), n, m, k, q.data(), out);
+	}, r);
+}
+
+void powMod(const limb *x, const limb *m, size_t k, const unsigned *e, size_t words, limb *r)
+{
+	if (m[0] % 2 != 0 && m[0] % 5 != 0) {
+		powModMontgomery(x, m, k, e, words, r);
+	} else {
+		powModDivide(x, m, k, e, words, r);
+	}
+}
+
+}
+
+// |*this| += |rhs|; rhs may be *this
+void Bint::_AddMagnitude(const Bint &rhs)
+{
+	size_t n = std::max(length, rhs.length) + 1;
+	_Grow(n);
+	memset(data + length, 0, (n - length) * sizeof(int));
+	BintKernel::addInPlace(data, n, rhs.data, rhs.length);
+	length = n;
+	while (length > 1 && data[length - 1] == 0) {
+		--length;
+	}
+}
+
+// |*this| -= |rhs|, the sign flipping when |rhs| is the larger; rhs may be *this
+void Bint::_SubMagnitude(const Bint &rhs)
+{
+	if (BintKernel::compareLimbs(data, length, rhs.data, rhs.length) >= 0) {
+		BintKernel::subInPlace(data, length, rhs.data, rhs.length);
+	} else {
+		_Grow(rhs.length);
+		memset(data + length, 0, (rhs.length - length) * sizeof(int));
+		BintKernel::subFrom(data, rhs.data, rhs.length);
+		length = rhs.length;
+		isMinus = !isMinus;
+	}
+	while (length > 1 && data[length - 1] == 0) {
+		--length;
+	}
+	if (length == 1 && data[0] == 0) {
+		isMinus = false;
+	}
+}
+
+Bint &Bint::operator+=(const Bint &rhs)
+{
+	if (isMinus == rhs.isMinus) {
+		_AddMagnitude(rhs);
 	} else {
-		return lhs + (-rhs);
+		_SubMagnitude(rhs);
 	}
+	return *this;
+}
+
+Bint &Bint::operator-=(const Bint &rhs)
+{
+	if (isMinus != rhs.isMinus) {
+		_AddMagnitude(rhs);
+	} else {
+		_SubMagnitude(rhs);
+	}
+	return *this;
+}
+
+Bint &Bint::operator*=(const Bint &rhs)
+{
+	return *this = *this * rhs;
+}
+
+Bint operator+(const Bint &lhs, const Bint &rhs)
+{
+	Bint result(std::max(lhs.length, rhs.length) + 1); // special constructor
+	result = lhs;
+	result += rhs;
+	return result;
+}
+
+Bint operator+(Bint &&lhs, const Bint &rhs)
+{
+	lhs += rhs;
+	return std::move(lhs);
+}
+
+Bint operator+(const Bint &lhs, Bint &&rhs)
+{
+	rhs += lhs;
+	return std::move(rhs);
+}
+
+Bint operator+(Bint &&lhs, Bint &&rhs)
+{
+	lhs += rhs;
+	return std::move(lhs);
+}
+
+Bint operator-(const Bint &b)
+{
+	Bint result(b);
+	result.isMinus = !result.isMinus && (result.length > 1 || result.data[0] != 0);
+	return result;
+}
+
+Bint operator-(Bint &&b)
+{
+	b.isMinus = !b.isMinus && (b.length > 1 || b.data[0] != 0);
+	return std::move(b);
+}
+
+Bint operator-(const Bint &lhs, const Bint &rhs)
+{
+	Bint result(std::max(lhs.length, rhs.length) + 1); // special constructor
+	result = lhs;
+	result -= rhs;
+	return result;
+}
+
+Bint operator-(Bint &&lhs, const Bint &rhs)
+{
+	lhs -= rhs;
+	return std::move(lhs);
+}
+
+Bint operator-(const Bint &lhs, Bint &&rhs)
+{
+	rhs -= lhs;
+	return -std::move(rhs);
+}
+
+Bint operator-(Bint &&lhs, Bint &&rhs)
+{
+	lhs -= rhs;
+	return std::move(lhs);
 }
 
 Bint operator*(const Bint &lhs, const Bint &rhs)
 {
-	size_t expectLen = lhs.length + rhs.length + 2;
+	size_t expectLen = lhs.length + rhs.length;
 	Bint result(expectLen);
-	for (size_t i = 0; i < lhs.length; ++i) {
-		for (size_t j = 0; j < rhs.length; ++j) {
-			long long tmp = result.data[i + j] + static_cast<long long>(lhs.data[i]) * rhs.data[j];
-			if (tmp >= 10000) {
-				result.data[i + j] = tmp % 10000;
-				result.data[i + j + 1] += static_cast<int>(tmp / 10000);
-			} else {
-				result.data[i + j] = tmp;
-			}
+	BintKernel::multiply(lhs.data, lhs.length, rhs.data, rhs.length, result.data);
+	result.length = expectLen;
+	while (result.length > 1 && result.data[result.length - 1] == 0) {
+		--result.length;
+	}
+	result.isMinus = lhs.isMinus != rhs.isMinus && (result.length > 1 || result.data[0] != 0);
+	return result;
+}
+
+// drops leading zero limbs; zero is never negative
+void Bint::_Trim()
+{
+	while (length > 1 && data[length - 1] == 0) {
+		--length;
+	}
+	if (length == 1 && data[0] == 0) {
+		isMinus = false;
+	}
+}
+
+// truncating division, as for built-in integers: the quotient rounds toward
+// zero and the remainder takes the sign of lhs; either output may be null
+// and either may be lhs or rhs
+void Bint::_DivMod(const Bint &lhs, const Bint &rhs, Bint *quotient, Bint *remainder)
+{
+	if (rhs.length == 1 && rhs.data[0] == 0) {
+		throw DivideByZero();
+	}
+	size_t n = lhs.length, m = rhs.length;
+	if (BintKernel::compareLimbs(lhs.data, n, rhs.data, m) < 0) {
+		if (remainder != nullptr) {
+			*remainder = lhs;
+		}
+		if (quotient != nullptr) {
+			*quotient = 0;
 		}
+		return;
 	}
-	result.length = lhs.length + rhs.length -1;
-	while (result.data[result.length] > 0) {
-		++result.length;
+	Bint q(n - m + 1), r(m); // special constructor
+	BintKernel::divide(lhs.data, n, rhs.data, m, q.data, r.data);
+	q.length = n - m + 1;
+	q.isMinus = lhs.isMinus != rhs.isMinus;
+	q._Trim();
+	r.length = m;
+	r.isMinus = lhs.isMinus;
+	r._Trim();
+	if (quotient != nullptr) {
+		*quotient = std::move(q);
 	}
-	while (result.length > 1 && result.data[result.length - 1] == 0) {
-		--result.length;
+	if (remainder != nullptr) {
+		*remainder = std::move(r);
 	}
+}
+
+Bint &Bint::operator/=(const Bint &rhs)
+{
+	_DivMod(*this, rhs, this, nullptr);
+	return *this;
+}
+
+Bint &Bint::operator%=(const Bint &rhs)
+{
+	_DivMod(*this, rhs, nullptr, this);
+	return *this;
+}
+
+Bint operator/(const Bint &lhs, const Bint &rhs)
+{
+	Bint result;
+	Bint::_DivMod(lhs, rhs, &result, nullptr);
 	return result;
 }
 
-Bint::~Bint()
+Bint operator%(const Bint &lhs, const Bint &rhs)
 {
-	if (data != nullptr) {
-		delete[] data;
-		data = nullptr;
+	Bint result;
+	Bint::_DivMod(lhs, rhs, nullptr, &result);
+	return result;
+}
+
+Bint pow(const Bint &base, unsigned long long exp)
+{
+	Bint result(1), square(base);
+	while (exp != 0) {
+		if (exp & 1) {
+			result *= square;
+		}
+		exp >>= 1;
+		if (exp != 0) {
+			square *= square;
+		}
+	}
+	return result;
+}
+
+// base^exp mod |mod|, in [0, |mod|)
+Bint powmod(const Bint &base, const Bint &exp, const Bint &mod)
+{
+	if (exp.isMinus) {
+		throw Bint::NegativeExponent();
 	}
+	Bint m = abs(mod);
+	Bint x = base % m;
+	if (x.isMinus) {
+		x += m;
+	}
+	size_t k = m.length;
+	if (k == 1 && m.data[0] == 1) {
+		return Bint();
+	}
+	// the exponent in 32-bit words, by repeated short division
+	std::vector<BintKernel::limb> rest(exp.data, exp.data + BintKernel::trimmed(exp.data, exp.length));
+	std::vector<unsigned> words;
+	while (!rest.empty()) {
+		unsigned long long r = 0;
+		for (size_t i = rest.size(); i-- > 0;) {
+			unsigned long long t = r * BintKernel::BASE + static_cast<unsigned long long>(rest[i]);
+			rest[i] = static_cast<BintKernel::limb>(t >> 32);
+			r = t & 0xffffffffULL;
+		}
+		words.push_back(static_cast<unsigned>(r));
+		rest.resize(BintKernel::trimmed(rest.data(), rest.size()));
+	}
+	std::vector<BintKernel::limb> padded(k);
+	std::copy(x.data, x.data + x.length, padded.begin());
+	Bint result(k); // special constructor
+	BintKernel::powMod(padded.data(), m.data, k, words.data(), words.size(), result.data);
+	result.length = k;
+	result._Trim();
+	return result;
+}
+
+Bint::~Bint()
+{
+	_Release();
 }
 }
@@ -0,0 +1,49 @@
+#ifndef DYNAMIC_TYPE_HPP
+#define DYNAMIC_TYPE_HPP
+
+/**
+ * An element type that owns heap memory and reports its number of live
+ * instances through *pct, so leaks and double frees show up as a
+ * counter mismatch.
+ */
+class DynamicType {
+public:
+    int *pct;
+    int *data;
+    DynamicType (int *p) : pct(p) , data(new int[2]) {
+        (*pct)++;
+    }
+    DynamicType (int *p, int x) : pct(p) , data(new int[2]) {
+        (*pct)++;
+        data[0] = x;
+    }
+    DynamicType (const DynamicType &other) : pct(other.pct), data(new int[2]) {
+        (*pct)++;
+        data[0] = other.data[0];
+    }
+    DynamicType &operator =(const DynamicType &other) {
+        if (this == &other) return *this;
+        (*pct)--;
+        pct = other.pct;
+        (*pct)++;
+        delete [] data;
+        data = new int[2];
+        data[0] = other.data[0];
+        return *this;
+    }
+    ~DynamicType() {
+        delete [] data;
+        (*pct)--;
+    }
+    bool operator == (const DynamicType &rhs) const {
+        return data[0] == rhs.data[0];
+    }
+    bool operator != (const DynamicType &rhs) const {
+        return data[0] != rhs.data[0];
+    }
+    bool operator < (const DynamicType &rhs) const {
+        return data[0] < rhs.data[0];
+    }
+};
+
+#endif
@@ -8,7 +8,12 @@
 #include <iostream>
 #include <list>
 
-const int N = 5e4;
+// scaled-up builds (the perf_* CTest cases) pass -DLIST_TEST_SCALE=k
+#ifndef LIST_TEST_SCALE
+#define LIST_TEST_SCALE 1
+#endif
+
+const int N = 5e4 * LIST_TEST_SCALE;
 
 template<typename T>
 bool equal(const std::list<T> &x, const sjtu::list<T> &y) {
@@ -3,53 +3,33 @@
 #include "class-integer.hpp"
 #include "class-matrix.hpp"
 #include "class-bint.hpp"
+#include "class-dynamic.hpp"
 #include "list.hpp"
 
 #include <iostream>
 #include <list>
 
-const int N = 5e4;
+// list_two_alloc links bench/alloc_counter.cpp and attributes the heap
+// traffic of the sjtu::list calls below to named regions
+#ifdef LIST_ALLOC_COUNTER
+#include "alloc_counter.hpp"
+#define ALLOC_REGION(name) alloc::Scope allocRegion(name)
+#define ALLOC_FORBIDDEN(name) alloc::ExpectNoAlloc allocRegion(name)
+#define ALLOC_VIOLATIONS() alloc::violations()
+#else
+#define ALLOC_REGION(name)
+#define ALLOC_FORBIDDEN(name)
+#define ALLOC_VIOLATIONS() 0
+#endif
+
+// scaled-up builds (the perf_* CTest cases) pass -DLIST_TEST_SCALE=k
+#ifndef LIST_TEST_SCALE
+#define LIST_TEST_SCALE 1
+#endif
+
+const int N = 5e4 * LIST_TEST_SCALE;
 
 int ansCounter = 0, myCounter = 0, noUseCounter = 0;
-class DynamicType {
-public:
-    int *pct;
-    int *data;
-    DynamicType (int *p) : pct(p) , data(new int[2]) {
-        (*pct)++;
-    }
-    DynamicType (int *p, int x) : pct(p) , data(new int[2]) {
-        (*pct)++;
-        data[0] = x;
-    }
-    DynamicType (const DynamicType &other) : pct(other.pct), data(new int[2]) {
-        (*pct)++;
-        data[0] = other.data[0];
-    }
-    DynamicType &operator =(const DynamicType &other) {
-        if (this == &other) return *this;
-        (*pct)--;
-        pct = other.pct;
-        (*pct)++;
-        delete [] data;
-        data = new int[2];
-        data[0] = other.data[0];
-        return *this;
-    }
-    ~DynamicType() {
-        delete [] data;
-        (*pct)--;
-    }
-    bool operator == (const DynamicType &rhs) const {
-        return data[0] == rhs.data[0];
-    }
-    bool operator != (const DynamicType &rhs) const {
-        return data[0] != rhs.data[0];
-    }
-    bool operator < (const DynamicType &rhs) const {
-        return data[0] < rhs.data[0];
-    }
-};
 
 template<typename T>
 bool equal(const std::list<T> &x, const sjtu::list<T> &y) {
@@ -179,7 +159,11 @@ bool testSort() {
         myList.push_back(DynamicType(&myCounter, val));
     }
 
-    ans.sort(), myList.sort();
+    ans.sort();
+    {
+        ALLOC_REGION("sort");
+        myList.sort();
+    }
     if (!equal(ans, myList))
         return false;
     return myCounter == ansCounter;
@@ -199,8 +183,12 @@ bool testMerge() {
 
     ans1.sort(), ans2.sort();
     myList1.sort(), myList2.sort();
-    ans1.merge(ans2), myList1.merge(myList2);
-    if (!equal(ans1, myList1))
+    ans1.merge(ans2);
+    {
+        ALLOC_FORBIDDEN("merge");
+        myList1.merge(myList2);
+    }
+    if (ALLOC_VIOLATIONS() || !equal(ans1, myList1))
         return false;
     return myCounter == ansCounter;
 }
@@ -214,8 +202,12 @@ bool testReverse() {
         myList.push_back(DynamicType(&myCounter, val));
     }
 
-    ans.reverse(), myList.reverse();
-    if (!equal(ans, myList))
+    ans.reverse();
+    {
+        ALLOC_FORBIDDEN("reverse");
+        myList.reverse();
+    }
+    if (ALLOC_VIOLATIONS() || !equal(ans, myList))
         return false;
     return myCounter == ansCounter;
 }
@@ -229,8 +221,12 @@ bool testUnique() {
         myList.push_back(DynamicType(&myCounter, val));
     }
 
-    ans.unique(), myList.unique();
-    if (!equal(ans, myList))
+    ans.unique();
+    {
+        ALLOC_FORBIDDEN("unique");
+        myList.unique();
+    }
+    if (ALLOC_VIOLATIONS() || !equal(ans, myList))
         return false;
     return myCounter == ansCounter;
 }
@@ -2,41 +2,63 @@
 #define SJTU_EXCEPTIONS_HPP
 
 #include <cstddef>
-#include <cstring>
-#include <string>
 
 /*
  * You don't have to implement exceptions.hpp.
  * Just remember to throw exception when needed.
+ *
+ * The messages are string literals, so constructing, copying and throwing
+ * an exception never allocates and what() only returns a pointer.
  */
 namespace sjtu {
 
 class exception {
 protected:
-    const std::string variant = "";
-    std::string detail = "";
+    const char *variant;
+    const char *detail;
+
+    exception(const char *variant, const char *detail) noexcept : variant(variant), detail(detail) {}
+
 public:
-    exception() {}
-    exception(const exception &ec) : variant(ec.variant), detail(ec.detail) {}
-    virtual std::string what() {
-        return variant + " " + detail;
+    exception() noexcept : variant("exception"), detail("exception: unspecified error") {}
+    exception(const exception &ec) noexcept = default;
+    exception &operator=(const exception &ec) noexcept = default;
+    virtual ~exception() = default;
+
+    /**
+     * "<variant>: <description>"
+     */
+    virtual const char *what() const noexcept {
+        return detail;
+    }
+
+    /**
+     * the class name, e.g. "container_is_empty"
+     */
+    const char *name() const noexcept {
+        return variant;
     }
 };
 
 class index_out_of_bound : public exception {
-    /* __________________________ */
+public:
+    index_out_of_bound() noexcept : exception("index_out_of_bound", "index_out_of_bound: index is out of range") {}
 };
 
 class runtime_error : public exception {
-    /* __________________________ */
+public:
+    runtime_error() noexcept : exception("runtime_error", "runtime_error: operation failed") {}
 };
 
 class invalid_iterator : public exception {
-    /* __________________________ */
+public:
+    invalid_iterator() noexcept
+            : exception("invalid_iterator", "invalid_iterator: iterator is singular, past the end or of another container") {}
 };
 
 class container_is_empty : public exception {
-    /* __________________________ */
+public:
+    container_is_empty() noexcept : exception("container_is_empty", "container_is_empty: the container is empty") {}
 };
 }
 
@@ -0,0 +1,601 @@
+/**
+ * list_fuzz: randomized differential tester for sjtu::list against std::list.
+ *
+ * Generates weighted random operation traces (push/pop, iterator based
+ * insert/erase, element access, sort, merge, unique, reverse, copy, clear)
+ * and applies each trace to both containers, comparing contents and the
+ * number of live elements after every step. Operations that are undefined
+ * for std::list (pop on empty, foreign iterators, ...) must throw from
+ * sjtu::list and leave it unchanged, and the try_ functions must report
+ * them by returning false / nullptr.
+ *
+ * On the first divergence the trace is shrunk to a minimal reproducer:
+ * it is cut after the failing step, chunks and single operations are
+ * dropped while the failure persists, and operands are made smaller.
+ *
+ *   list_fuzz [--seed N] [--traces N] [--length N] [--seconds S] [--keys N] [--unstable-sort]
+ *
+ * Elements carry a key and a unique id; operator< and operator== only look
+ * at the key, while contents are compared by key and id, so merge and
+ * unique must keep exactly the elements std::list keeps. sort() must be
+ * stable like std::list::sort; --unstable-sort only requires key order.
+ *
+ * Built with SJTU_LIST_STATS it also checks that the node counters of
+ * list::stats() account for every element.
+ */
+
+#include "list.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+template<int Tag>
+class Item {
+public:
+    static int live;
+    int key;
+    int id;
+
+    Item(int key, int id) : key(key), id(id) {
+        ++live;
+    }
+
+    Item(const Item &other) : key(other.key), id(other.id) {
+        ++live;
+    }
+
+    Item &operator=(const Item &other) {
+        key = other.key;
+        id = other.id;
+        return *this;
+    }
+
+    ~Item() {
+        --live;
+    }
+
+    bool operator<(const Item &rhs) const {
+        return key < rhs.key;
+    }
+
+    bool operator==(const Item &rhs) const {
+        return key == rhs.key;
+    }
+};
+
+template<int Tag>
+int Item<Tag>::live = 0;
+
+typedef Item<0> StdItem;
+typedef Item<1> MyItem;
+
+enum OpCode {
+    PushBack, PushFront, PopBack, PopFront, Insert, Erase, Access, Walk,
+    Sort, Merge, Unique, Reverse, Copy, Assign, Clear, ForeignInsert, EndAccess, TryPop, TryErase,
+    OpCount
+};
+
+const char *opNames[OpCount] = {
+    "push_back", "push_front", "pop_back", "pop_front", "insert", "erase", "front/back", "walk",
+    "sort", "merge", "unique", "reverse", "copy", "assign", "clear", "foreign_insert", "end_access",
+    "try_pop", "try_erase"
+};
+
+const int opWeights[OpCount] = {
+    12, 12, 6, 6, 14, 10, 4, 4,
+    3, 3, 4, 3, 2, 2, 1, 1, 1, 4, 4
+};
+
+/**
+ * one step of a trace. pos selects an iterator position (taken modulo the
+ * size), fromEnd walks there with -- from end() instead of ++ from begin(),
+ * key is the key of a new element and keys fills the other list of merge.
+ */
+struct Op {
+    OpCode code;
+    int pos;
+    bool fromEnd;
+    int key;
+    std::vector<int> keys;
+};
+
+struct Failure {
+    bool failed;
+    size_t step;
+    std::string what;
+};
+
+std::string show(const Op &op) {
+    std::ostringstream ss;
+    ss << opNames[op.code];
+    switch (op.code) {
+        case PushBack: case PushFront:
+            ss << " key=" << op.key;
+            break;
+        case Insert:
+            ss << " pos=" << op.pos << (op.fromEnd ? " from end" : " from begin") << " key=" << op.key;
+            break;
+        case TryPop:
+            ss << (op.fromEnd ? " back" : " front");
+            break;
+        case Erase: case Walk: case TryErase:
+            ss << " pos=" << op.pos << (op.fromEnd ? " from end" : " from begin");
+            break;
+        case Merge:
+            ss << " keys=[";
+            for (size_t i = 0; i < op.keys.size(); ++i) ss << (i ? " " : "") << op.keys[i];
+            ss << "]";
+            break;
+        default:
+            break;
+    }
+    return ss.str();
+}
+
+template<typename List>
+std::string dump(const List &l) {
+    std::ostringstream ss;
+    ss << "[";
+    bool first = true;
+    for (typename List::const_iterator it = l.cbegin(); it != l.cend(); ++it) {
+        ss << (first ? "" : " ") << it->key << "#" << it->id;
+        first = false;
+    }
+    ss << "]";
+    return ss.str();
+}
+
+bool sameContents(const std::list<StdItem> &x, const sjtu::list<MyItem> &y, bool byKeyOnly) {
+    if (x.size() != y.size()) return false;
+    std::list<StdItem>::const_iterator itx = x.cbegin();
+    sjtu::list<MyItem>::const_iterator ity = y.cbegin();
+    for (; itx != x.cend(); ++itx, ++ity) {
+        if (itx->key != ity->key) return false;
+        if (!byKeyOnly && itx->id != ity->id) return false;
+    }
+    return ity == y.cend();
+}
+
+template<typename List>
+typename List::iterator position(List &l, int pos, bool fromEnd) {
+    typename List::iterator it = fromEnd ? l.end() : l.begin();
+    for (int i = 0; i < pos; ++i) {
+        if (fromEnd) --it; else ++it;
+    }
+    return it;
+}
+
+template<typename Exception, typename Action>
+bool throws(Action action) {
+    try {
+        action();
+    } catch (Exception &) {
+        return true;
+    } catch (...) {
+        return false;
+    }
+    return false;
+}
+
+class Executor {
+private:
+    bool stableSort;
+    std::list<StdItem> ans;
+    sjtu::list<MyItem> mine;
+    int nextId;
+    size_t adopted;  // nodes merged into mine from other lists
+
+    Failure fail(size_t step, const std::string &what) {
+        Failure f;
+        f.failed = true;
+        f.step = step;
+        f.what = what;
+        return f;
+    }
+
+    /**
+     * adopt sjtu::list's order of equal keys after an unstable sort.
+     */
+    void adoptOrder() {
+        ans.clear();
+        for (sjtu::list<MyItem>::const_iterator it = mine.cbegin(); it != mine.cend(); ++it) {
+            ans.push_back(StdItem(it->key, it->id));
+        }
+    }
+
+    bool sorted() const {
+        for (std::list<StdItem>::const_iterator it = ans.cbegin(), nx; it != ans.cend(); ++it) {
+            nx = it;
+            if (++nx != ans.cend() && *nx < *it) return false;
+        }
+        return true;
+    }
+
+    /**
+     * apply op to both lists; returns an empty string or what went wrong.
+     */
+    std::string apply(const Op &op) {
+        size_t size = ans.size();
+        switch (op.code) {
+            case PushBack:
+                ans.push_back(StdItem(op.key, nextId));
+                mine.push_back(MyItem(op.key, nextId++));
+                break;
+            case PushFront:
+                ans.push_front(StdItem(op.key, nextId));
+                mine.push_front(MyItem(op.key, nextId++));
+                break;
+            case PopBack:
+            case PopFront:
+                if (size == 0) {
+                    bool thrown = op.code == PopBack
+                                  ? throws<sjtu::container_is_empty>([&] { mine.pop_back(); })
+                                  : throws<sjtu::container_is_empty>([&] { mine.pop_front(); });
+                    if (!thrown) return "pop on an empty list did not throw container_is_empty";
+                } else if (op.code == PopBack) {
+                    ans.pop_back();
+                    mine.pop_back();
+                } else {
+                    ans.pop_front();
+                    mine.pop_front();
+                }
+                break;
+            case Insert: {
+                int pos = op.pos % static_cast<int>(size + 1);
+                std::list<StdItem>::iterator r1 = ans.insert(position(ans, pos, op.fromEnd), StdItem(op.key, nextId));
+                sjtu::list<MyItem>::iterator r2 = mine.insert(position(mine, pos, op.fromEnd), MyItem(op.key, nextId++));
+                if (r1->id != r2->id) return "insert returned an iterator to the wrong element";
+                break;
+            }
+            case Erase: {
+                if (size == 0) {
+                    if (!throws<sjtu::exception>([&] { mine.erase(mine.begin()); })) {
+                        return "erase on an empty list did not throw";
+                    }
+                    break;
+                }
+                int pos = op.pos % static_cast<int>(size) + (op.fromEnd ? 1 : 0);
+                std::list<StdItem>::iterator r1 = ans.erase(position(ans, pos, op.fromEnd));
+                sjtu::list<MyItem>::iterator r2 = mine.erase(position(mine, pos, op.fromEnd));
+                if ((r1 == ans.end()) != (r2 == mine.end())) return "erase returned the wrong iterator";
+                if (r1 != ans.end() && r1->id != r2->id) return "erase returned an iterator to the wrong element";
+                break;
+            }
+            case Access:
+                if (size == 0) {
+                    if (!throws<sjtu::container_is_empty>([&] { mine.front(); }) ||
+                        !throws<sjtu::container_is_empty>([&] { mine.back(); })) {
+                        return "front()/back() on an empty list did not throw container_is_empty";
+                    }
+                    if (mine.try_front() != nullptr || mine.try_back() != nullptr) {
+                        return "try_front()/try_back() on an empty list did not return nullptr";
+                    }
+                } else if (ans.front().id != mine.front().id || ans.back().id != mine.back().id) {
+                    return "front()/back() returned the wrong element";
+                } else if (mine.try_front() != &mine.front() || mine.try_back() != &mine.back()) {
+                    return "try_front()/try_back() disagree with front()/back()";
+                }
+                break;
+            case Walk: {
+                if (size == 0) break;
+                int pos = op.pos % static_cast<int>(size) + (op.fromEnd ? 1 : 0);
+                std::list<StdItem>::iterator i1 = position(ans, pos, op.fromEnd);
+                sjtu::list<MyItem>::iterator i2 = position(mine, pos, op.fromEnd);
+                for (; i1 != ans.end(); ++i1, ++i2) {
+                    if (i2 == mine.end() || i1->id != (*i2).id) return "forward walk disagrees";
+                }
+                if (i2 != mine.end()) return "forward walk disagrees";
+                while (i1 != ans.begin()) {
+                    --i1, --i2;
+                    if (i1->id != i2->id) return "backward walk disagrees";
+                }
+                if (i2 != mine.begin()) return "backward walk disagrees";
+                if (!throws<sjtu::invalid_iterator>([&] { --i2; })) return "-- on begin() did not throw";
+                break;
+            }
+            case Sort:
+                ans.sort();
+                mine.sort();
+                if (!stableSort && sameContents(ans, mine, true)) adoptOrder();
+                break;
+            case Merge: {
+                if (!sorted()) {
+                    ans.sort();
+                    mine.sort();
+                    if (!stableSort && sameContents(ans, mine, true)) adoptOrder();
+                }
+                std::vector<int> keys = op.keys;
+                std::sort(keys.begin(), keys.end());
+                std::list<StdItem> other1;
+                sjtu::list<MyItem> other2;
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    other1.push_back(StdItem(keys[i], nextId));
+                    other2.push_back(MyItem(keys[i], nextId++));
+                }
+                ans.merge(other1);
+                mine.merge(other2);
+                adopted += keys.size();
+                if (!other2.empty() || other2.size() != 0) return "merge left elements in the other list";
+                break;
+            }
+            case Unique:
+                ans.unique();
+                mine.unique();
+                break;
+            case Reverse:
+                ans.reverse();
+                mine.reverse();
+                break;
+            case Copy: {
+                sjtu::list<MyItem> copy(mine);
+                if (!sameContents(ans, copy, false)) return "copy constructor produced different contents";
+                copy.push_back(MyItem(-1, -1));
+                if (mine.size() != size) return "copy shares state with the original";
+                break;
+            }
+            case Assign: {
+                sjtu::list<MyItem> other;
+                other.push_back(MyItem(-1, -1));
+                other = mine;
+                if (!sameContents(ans, other, false)) return "operator= produced different contents";
+                mine = mine;
+                break;
+            }
+            case Clear:
+                ans.clear();
+                mine.clear();
+                if (!mine.empty()) return "clear() left elements behind";
+                break;
+            case ForeignInsert: {
+                sjtu::list<MyItem> other;
+                if (!throws<sjtu::invalid_iterator>([&] { mine.insert(other.end(), MyItem(0, -1)); })) {
+                    return "insert with an iterator of another list did not throw invalid_iterator";
+                }
+                other.push_back(MyItem(0, -1));
+                if (mine.try_erase(other.begin()) || mine.try_erase(mine.end()) ||
+                    mine.try_erase(sjtu::list<MyItem>::iterator())) {
+                    return "try_erase accepted an iterator that is not an element of the list";
+                }
+                break;
+            }
+            case EndAccess:
+                if (!throws<sjtu::invalid_iterator>([&] { *mine.end(); }) ||
+                    !throws<sjtu::invalid_iterator>([&] { ++mine.end(); })) {
+                    return "dereferencing / incrementing end() did not throw invalid_iterator";
+                }
+                break;
+            case TryPop:
+                if (op.fromEnd ? mine.try_pop_back() : mine.try_pop_front()) {
+                    if (size == 0) return "try_pop on an empty list returned true";
+                    if (op.fromEnd) ans.pop_back(); else ans.pop_front();
+                } else if (size != 0) {
+                    return "try_pop on a non-empty list returned false";
+                }
+                break;
+            case TryErase: {
+                sjtu::list<MyItem>::iterator next;
+                if (size == 0) {
+                    if (mine.try_erase(mine.begin(), next)) return "try_erase on an empty list returned true";
+                    break;
+                }
+                int pos = op.pos % static_cast<int>(size) + (op.fromEnd ? 1 : 0);
+                std::list<StdItem>::iterator r1 = ans.erase(position(ans, pos, op.fromEnd));
+                if (!mine.try_erase(position(mine, pos, op.fromEnd), next)) return "try_erase of an element returned false";
+                if ((r1 == ans.end()) != (next == mine.end())) return "try_erase returned the wrong iterator";
+                if (r1 != ans.end() && r1->id != next->id) return "try_erase returned an iterator to the wrong element";
+                break;
+            }
+            default:
+                break;
+        }
+        return "";
+    }
+
+public:
+    explicit Executor(bool stableSort) : stableSort(stableSort), nextId(0), adopted(0) {}
+
+    Failure run(const std::vector<Op> &trace) {
+        for (size_t i = 0; i < trace.size(); ++i) {
+            std::string what;
+            try {
+                what = apply(trace[i]);
+            } catch (sjtu::exception &) {
+                what = "unexpected sjtu::exception";
+            } catch (...) {
+                what = "unexpected exception";
+            }
+            if (what.empty() && ans.size() != mine.size()) what = "size() differs";
+            if (what.empty() && mine.empty() != (mine.size() == 0)) what = "empty() disagrees with size()";
+            if (what.empty() && !sameContents(ans, mine, false)) what = "contents differ";
+            if (what.empty() && StdItem::live != MyItem::live) what = "number of live elements differs";
+            if (what.empty() && (mine.memory_footprint().nodes != mine.size() ||
+                                 mine.locality_report().links != (mine.empty() ? 0 : mine.size() - 1))) {
+                what = "memory_footprint() / locality_report() disagree with size()";
+            }
+#ifdef SJTU_LIST_STATS
+            sjtu::list_stats st = mine.stats();
+            if (what.empty() && st.nodes_allocated + adopted - st.nodes_freed != mine.size()) {
+                what = "stats() node counters do not add up to size()";
+            }
+#endif
+            if (!what.empty()) {
+                return fail(i, what + "\n    std::list  " + dump(ans) + "\n    sjtu::list " + dump(mine));
+            }
+        }
+        Failure ok = Failure();
+        ok.failed = false;
+        return ok;
+    }
+};
+
+Failure execute(const std::vector<Op> &trace, bool stableSort) {
+    Failure f;
+    {
+        Executor executor(stableSort);
+        f = executor.run(trace);
+    }
+    if (!f.failed && (StdItem::live != 0 || MyItem::live != 0)) {
+        f.failed = true;
+        f.step = trace.size() - 1;
+        f.what = "elements leaked after destruction";
+    }
+    StdItem::live = MyItem::live = 0;
+    return f;
+}
+
+class Generator {
+private:
+    std::mt19937 rng;
+    int keys;
+    int totalWeight;
+
+public:
+    Generator(unsigned seed, int keys) : rng(seed), keys(keys), totalWeight(0) {
+        for (int i = 0; i < OpCount; ++i) totalWeight += opWeights[i];
+    }
+
+    Op next() {
+        int r = static_cast<int>(rng() % totalWeight);
+        int code = 0;
+        while (r >= opWeights[code]) r -= opWeights[code++];
+        Op op;
+        op.code = static_cast<OpCode>(code);
+        op.pos = static_cast<int>(rng() % 64);
+        op.fromEnd = rng() % 2;
+        op.key = static_cast<int>(rng() % keys);
+        if (op.code == Merge) {
+            size_t count = rng() % 8;
+            for (size_t i = 0; i < count; ++i) op.keys.push_back(static_cast<int>(rng() % keys));
+        }
+        return op;
+    }
+
+    std::vector<Op> trace(size_t length) {
+        std::vector<Op> ops;
+        for (size_t i = 0; i < length; ++i) ops.push_back(next());
+        return ops;
+    }
+};
+
+/**
+ * shrink a failing trace while it keeps failing.
+ */
+std::vector<Op> shrink(std::vector<Op> trace, bool stableSort) {
+    Failure f = execute(trace, stableSort);
+    trace.resize(f.step + 1);
+
+    // drop chunks, halving the chunk size down to single operations
+    for (size_t chunk = trace.size() / 2; chunk >= 1; chunk /= 2) {
+        for (size_t start = 0; start + chunk <= trace.size();) {
+            std::vector<Op> candidate(trace.begin(), trace.begin() + start);
+            candidate.insert(candidate.end(), trace.begin() + start + chunk, trace.end());
+            Failure g = execute(candidate, stableSort);
+            if (!candidate.empty() && g.failed) {
+                candidate.resize(g.step + 1);
+                trace = candidate;
+            } else {
+                start += chunk;
+            }
+        }
+    }
+
+    // make operands smaller
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (size_t i = 0; i < trace.size(); ++i) {
+            std::vector<Op> variants;
+            Op op = trace[i];
+            if (op.pos > 0) { Op v = op; v.pos = 0; variants.push_back(v); v.pos = op.pos / 2; variants.push_back(v); }
+            if (op.key > 0) { Op v = op; v.key = 0; variants.push_back(v); v.key = op.key / 2; variants.push_back(v); }
+            if (op.fromEnd) { Op v = op; v.fromEnd = false; variants.push_back(v); }
+            for (size_t k = 0; k < op.keys.size(); ++k) {
+                Op v = op;
+                v.keys.erase(v.keys.begin() + k);
+                variants.push_back(v);
+                if (op.keys[k] > 0) { v = op; v.keys[k] = 0; variants.push_back(v); }
+            }
+            for (size_t k = 0; k < variants.size(); ++k) {
+                std::vector<Op> candidate = trace;
+                candidate[i] = variants[k];
+                if (execute(candidate, stableSort).failed) {
+                    trace = candidate;
+                    progress = true;
+                    break;
+                }
+            }
+        }
+    }
+    return trace;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--seed N] [--traces N] [--length N] [--seconds S] [--keys N] [--unstable-sort]\n", prog);
+}
+
+}
+
+int main(int argc, char **argv) {
+    unsigned seed = static_cast<unsigned>(std::chrono::steady_clock::now().time_since_epoch().count());
+    long traces = 1000;
+    size_t length = 200;
+    double seconds = 0;
+    int keys = 16;
+    bool stableSort = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue) {
+            seed = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--traces" && hasValue) {
+            traces = atol(argv[++i]);
+        } else if (arg == "--length" && hasValue) {
+            length = static_cast<size_t>(atol(argv[++i]));
+        } else if (arg == "--seconds" && hasValue) {
+            seconds = atof(argv[++i]);
+        } else if (arg == "--keys" && hasValue) {
+            keys = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--unstable-sort") {
+            stableSort = false;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    printf("list_fuzz: seed %u, %s, %zu ops per trace\n", seed,
+           seconds > 0 ? (std::to_string(seconds) + " s").c_str() : (std::to_string(traces) + " traces").c_str(), length);
+    Generator gen(seed, keys);
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (long n = 0;; ++n) {
+        if (seconds > 0) {
+            std::chrono::duration<double> spent = std::chrono::steady_clock::now() - begin;
+            if (spent.count() >= seconds) break;
+        } else if (n >= traces) {
+            break;
+        }
+        std::vector<Op> trace = gen.trace(length);
+        if (!execute(trace, stableSort).failed) continue;
+
+        printf("divergence in trace %ld, shrinking %zu ops...\n", n, trace.size());
+        std::vector<Op> minimal = shrink(trace, stableSort);
+        Failure f = execute(minimal, stableSort);
+        printf("minimal reproducer (%zu ops):\n", minimal.size());
+        for (size_t i = 0; i < minimal.size(); ++i) {
+            printf("  %3zu: %s\n", i, show(minimal[i]).c_str());
+        }
+        printf("step %zu: %s\n", f.step, f.what.c_str());
+        return 1;
+    }
+    printf("no divergence found\n");
+    return 0;
+}
@@ -6,8 +6,96 @@
 
 #include <climits>
 #include <cstddef>
+#include <cstring>
+
+#ifdef SJTU_LIST_STATS
+#include <chrono>
+#endif
+
+#ifdef SJTU_LIST_TRACE
+#include "list_trace.hpp"
+#endif
 
 namespace sjtu {
+
+/**
+ * log2-bucketed latency histogram: buckets[i] counts the calls that took
+ * [2^i, 2^(i+1)) nanoseconds.
+ */
+struct list_latency {
+    static const int BUCKETS = 40;
+    size_t buckets[BUCKETS];
+    size_t calls;
+    size_t total_ns;
+};
+
+/**
+ * snapshot of the counters every list keeps when SJTU_LIST_STATS is defined.
+ * Without it nothing is counted, no space is used and stats() is all zero.
+ */
+struct list_stats {
+    size_t push_back, push_front, pop_back, pop_front, insert, erase;
+    size_t sort, merge, unique, reverse;
+    size_t nodes_allocated, nodes_freed;
+    size_t sort_comparisons, merge_comparisons, unique_comparisons;
+    list_latency sort_latency, merge_latency, unique_latency, reverse_latency, copy_latency, clear_latency;
+};
+
+/**
+ * shallow memory use of a list: what the list itself allocates, not memory
+ * owned by the elements. Every element costs one node and one separately
+ * allocated T; the two sentinels are nodes without payload.
+ */
+struct list_footprint {
+    size_t nodes;           // element nodes
+    size_t node_bytes;      // nodes * sizeof(node)
+    size_t payload_bytes;   // nodes * sizeof(T)
+    size_t sentinel_bytes;  // 2 * sizeof(node)
+    size_t overhead_bytes;  // estimated malloc headers and rounding for all of the above
+    size_t total_bytes;     // sum of the four, plus the list object itself
+};
+
+/**
+ * how scattered the nodes of a list are in memory, measured along the list
+ * order. Distances are absolute byte differences between consecutive node
+ * addresses; percentiles are the upper bounds of their log2 buckets.
+ */
+struct list_locality {
+    size_t links;               // consecutive node pairs measured (size() - 1)
+    double mean_distance;
+    size_t p50_distance, p90_distance, p99_distance, max_distance;
+    double forward_rate;        // share of links that go to a higher address
+    double page_crossing_rate;  // share of links whose nodes lie on different pages
+    double payload_split_rate;  // share of elements whose payload is not on their node's page
+};
+
+#ifdef SJTU_LIST_STATS
+#define SJTU_LIST_COUNT(field) (++statsData.field)
+#define SJTU_LIST_TIME(field) latency_scope sjtuListLatency(statsData.field)
+#else
+#define SJTU_LIST_COUNT(field) ((void)0)
+#define SJTU_LIST_TIME(field) ((void)0)
+#endif
+
+#ifdef SJTU_LIST_TRACE
+#define SJTU_LIST_TRACE_OP(op) tracing::scope sjtuListTrace(tracing::op, this, listSize)
+#else
+#define SJTU_LIST_TRACE_OP(op) ((void)0)
+#endif
+
+/**
+ * iterator validity checks (dereference, ++ / --, the iterator passed to
+ * insert / erase). SJTU_LIST_NO_ITERATOR_CHECKS compiles them out; using an
+ * invalid iterator is then undefined behaviour, as with std::list. The
+ * try_ functions always check.
+ */
+#ifdef SJTU_LIST_NO_ITERATOR_CHECKS
+#define SJTU_LIST_CHECK_ITERATOR(invalid) ((void)0)
+#else
+#define SJTU_LIST_CHECK_ITERATOR(invalid) \
+    do { if (__builtin_expect(static_cast<bool>(invalid), 0)) throw invalid_iterator(); } while (0)
+#endif
+
 /**
  * a data container like std::list
  * allocate random memory addresses for data and they are doubly-linked in a list.
@@ -35,10 +123,50 @@ protected:
         }
     };
 
+#ifdef SJTU_LIST_STATS
+    /**
+     * adds the lifetime of the scope to a latency histogram.
+     */
+    class latency_scope {
+    private:
+        list_latency &hist;
+        std::chrono::steady_clock::time_point begin;
+
+    public:
+        explicit latency_scope(list_latency &hist) : hist(hist), begin(std::chrono::steady_clock::now()) {}
+
+        ~latency_scope() {
+            size_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - begin).count();
+            int b = 0;
+            while (b + 1 < list_latency::BUCKETS && (size_t(1) << (b + 1)) <= ns) ++b;
+            ++hist.buckets[b];
+            ++hist.calls;
+            hist.total_ns += ns;
+        }
+    };
+#endif
+
 protected:
     node *head;  // sentinel node
     node *tail;  // sentinel node
     size_t listSize;
+#ifdef SJTU_LIST_STATS
+    list_stats statsData;
+#endif
+
+    /**
+     * allocate / free an element node
+     */
+    node *create(const T &value) {
+        SJTU_LIST_COUNT(nodes_allocated);
+        return new node(value);
+    }
+
+    void destroy(node *pos) {
+        SJTU_LIST_COUNT(nodes_freed);
+        delete pos;
+    }
 
     /**
      * insert node cur before node pos
@@ -79,9 +207,7 @@ public:
          * iter++
          */
         iterator operator++(int) {
-            if (ptr == nullptr || ptr->next == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->next == nullptr);
             iterator temp = *this;
             ptr = ptr->next;
             return temp;
@@ -91,9 +217,7 @@ public:
          * ++iter
          */
         iterator & operator++() {
-            if (ptr == nullptr || ptr->next == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->next == nullptr);
             ptr = ptr->next;
             return *this;
         }
@@ -102,9 +226,7 @@ public:
          * iter--
          */
         iterator operator--(int) {
-            if (ptr == nullptr || ptr->prev == nullptr || ptr->prev->data == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->prev == nullptr || ptr->prev->data == nullptr);
             iterator temp = *this;
             ptr = ptr->prev;
             return temp;
@@ -114,9 +236,7 @@ public:
          * --iter
          */
         iterator & operator--() {
-            if (ptr == nullptr || ptr->prev == nullptr || ptr->prev->data == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->prev == nullptr || ptr->prev->data == nullptr);
             ptr = ptr->prev;
             return *this;
         }
@@ -126,9 +246,7 @@ public:
          * remember to throw if iterator is invalid
          */
         T & operator *() const {
-            if (ptr == nullptr || ptr->data == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->data == nullptr);
             return *(ptr->data);
         }
 
@@ -137,9 +255,7 @@ public:
          * remember to throw if iterator is invalid
          */
         T * operator ->() const {
-            if (ptr == nullptr || ptr->data == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->data == nullptr);
             return ptr->data;
         }
 
@@ -186,9 +302,7 @@ public:
          * iter++
          */
         const_iterator operator++(int) {
-            if (ptr == nullptr || ptr->next == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->next == nullptr);
             const_iterator temp = *this;
             ptr = ptr->next;
             return temp;
@@ -198,9 +312,7 @@ public:
          * ++iter
          */
         const_iterator & operator++() {
-            if (ptr == nullptr || ptr->next == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->next == nullptr);
             ptr = ptr->next;
             return *this;
         }
@@ -209,9 +321,7 @@ public:
          * iter--
          */
         const_iterator operator--(int) {
-            if (ptr == nullptr || ptr->prev == nullptr || ptr->prev->data == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->prev == nullptr || ptr->prev->data == nullptr);
             const_iterator temp = *this;
             ptr = ptr->prev;
             return temp;
@@ -221,9 +331,7 @@ public:
          * --iter
          */
         const_iterator & operator--() {
-            if (ptr == nullptr || ptr->prev == nullptr || ptr->prev->data == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->prev == nullptr || ptr->prev->data == nullptr);
             ptr = ptr->prev;
             return *this;
         }
@@ -232,9 +340,7 @@ public:
          * *it
          */
         const T & operator *() const {
-            if (ptr == nullptr || ptr->data == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->data == nullptr);
             return *(ptr->data);
         }
 
@@ -242,9 +348,7 @@ public:
          * it->field
          */
         const T * operator ->() const {
-            if (ptr == nullptr || ptr->data == nullptr) {
-                throw invalid_iterator();
-            }
+            SJTU_LIST_CHECK_ITERATOR(ptr == nullptr || ptr->data == nullptr);
             return ptr->data;
         }
 
@@ -269,21 +373,32 @@ public:
      * Constructs
      * Atleast two: default constructor, copy constructor
      */
-    list() : listSize(0) {
+    list() : listSize(0)
+#ifdef SJTU_LIST_STATS
+        , statsData()
+#endif
+    {
         head = new node();
         tail = new node();
         head->next = tail;
         tail->prev = head;
     }
 
-    list(const list &other) : listSize(0) {
+    list(const list &other) : listSize(0)
+#ifdef SJTU_LIST_STATS
+        , statsData()
+#endif
+    {
+        SJTU_LIST_TIME(copy_latency);
+        SJTU_LIST_TRACE_OP(Copy);
         head = new node();
         tail = new node();
         head->next = tail;
         tail->prev = head;
 
         for (node *cur = other.head->next; cur != other.tail; cur = cur->next) {
-            push_back(*(cur->data));
+            insert(tail, create(*(cur->data)));
+            listSize++;
         }
     }
 
@@ -303,8 +418,11 @@ public:
         if (this == &other) return *this;
 
         clear();
+        SJTU_LIST_TIME(copy_latency);
+        SJTU_LIST_TRACE_OP(Copy);
         for (node *cur = other.head->next; cur != other.tail; cur = cur->next) {
-            push_back(*(cur->data));
+            insert(tail, create(*(cur->data)));
+            listSize++;
         }
         return *this;
     }
@@ -381,10 +499,12 @@ public:
      * clears the contents
      */
     virtual void clear() {
+        SJTU_LIST_TIME(clear_latency);
+        SJTU_LIST_TRACE_OP(Clear);
         node *cur = head->next;
         while (cur != tail) {
             node *next = cur->next;
-            delete cur;
+            destroy(cur);
             cur = next;
         }
         head->next = tail;
@@ -398,10 +518,10 @@ public:
      * throw if the iterator is invalid
      */
     virtual iterator insert(iterator pos, const T &value) {
-        if (pos.listPtr != this) {
-            throw invalid_iterator();
-        }
-        node *newNode = new node(value);
+        SJTU_LIST_CHECK_ITERATOR(pos.listPtr != this);
+        SJTU_LIST_COUNT(insert);
+        SJTU_LIST_TRACE_OP(Insert);
+        node *newNode = create(value);
         insert(pos.ptr, newNode);
         listSize++;
         return iterator(newNode, this);
@@ -416,12 +536,12 @@ public:
         if (empty()) {
             throw container_is_empty();
         }
-        if (pos.listPtr != this || pos.ptr == nullptr || pos.ptr->data == nullptr) {
-            throw invalid_iterator();
-        }
+        SJTU_LIST_CHECK_ITERATOR(!owns(pos));
+        SJTU_LIST_COUNT(erase);
+        SJTU_LIST_TRACE_OP(Erase);
         node *next = pos.ptr->next;
         erase(pos.ptr);
-        delete pos.ptr;
+        destroy(pos.ptr);
         listSize--;
         return iterator(next, this);
     }
@@ -430,7 +550,9 @@ public:
      * adds an element to the end
      */
     void push_back(const T &value) {
-        node *newNode = new node(value);
+        SJTU_LIST_COUNT(push_back);
+        SJTU_LIST_TRACE_OP(PushBack);
+        node *newNode = create(value);
         insert(tail, newNode);
         listSize++;
     }
@@ -443,9 +565,11 @@ public:
         if (empty()) {
             throw container_is_empty();
         }
+        SJTU_LIST_COUNT(pop_back);
+        SJTU_LIST_TRACE_OP(PopBack);
         node *last = tail->prev;
         erase(last);
-        delete last;
+        destroy(last);
         listSize--;
     }
 
@@ -453,7 +577,9 @@ public:
      * inserts an element to the beginning.
      */
     void push_front(const T &value) {
-        node *newNode = new node(value);
+        SJTU_LIST_COUNT(push_front);
+        SJTU_LIST_TRACE_OP(PushFront);
+        node *newNode = create(value);
         insert(head->next, newNode);
         listSize++;
     }
@@ -466,18 +592,115 @@ public:
         if (empty()) {
             throw container_is_empty();
         }
+        SJTU_LIST_COUNT(pop_front);
+        SJTU_LIST_TRACE_OP(PopFront);
         node *first = head->next;
         erase(first);
-        delete first;
+        destroy(first);
         listSize--;
     }
 
     /**
-     * sort the values in ascending order with operator< of T
+     * non-throwing access and removal for callers that expect failures
+     * (empty lists, stale iterators) on hot paths.
+     * try_front / try_back return nullptr when the container is empty.
      */
-    void sort() {
-        if (listSize <= 1) return;
+    T *try_front() noexcept {
+        return empty() ? nullptr : head->next->data;
+    }
+
+    T *try_back() noexcept {
+        return empty() ? nullptr : tail->prev->data;
+    }
+
+    const T *try_front() const noexcept {
+        return empty() ? nullptr : head->next->data;
+    }
+
+    const T *try_back() const noexcept {
+        return empty() ? nullptr : tail->prev->data;
+    }
+
+    /**
+     * remove the first / last element; false when the container is empty.
+     */
+    bool try_pop_front() {
+        if (empty()) return false;
+        pop_front();
+        return true;
+    }
+
+    bool try_pop_back() {
+        if (empty()) return false;
+        pop_back();
+        return true;
+    }
+
+    /**
+     * remove the element at pos and store the following iterator in next;
+     * false, with next untouched, when pos is not a dereferenceable
+     * iterator of this list. Checks even with SJTU_LIST_NO_ITERATOR_CHECKS.
+     */
+    bool try_erase(iterator pos, iterator &next) {
+        if (!owns(pos)) return false;
+        next = erase(pos);
+        return true;
+    }
+
+    bool try_erase(iterator pos) {
+        iterator next;
+        return try_erase(pos, next);
+    }
+
+private:
+    /**
+     * whether pos points at an element of this list
+     */
+    bool owns(const iterator &pos) const {
+        return pos.listPtr == this && pos.ptr != nullptr && pos.ptr->data != nullptr;
+    }
+
+    /**
+     * values of trivially copyable types up to this size are sorted in a
+     * contiguous buffer and copied back into the nodes; larger or
+     * non-trivial types sort an array of data pointers instead.
+     */
+    static const size_t SORT_BY_VALUE_MAX_SIZE = 32;
+
+    template<bool ByValue>
+    struct sort_tag {};
+
+    /**
+     * sort a contiguous copy of the values: the kernel streams through
+     * memory instead of dereferencing a pointer per comparison, and
+     * integers get the branch-free network kernel of stable_sort.
+     * Copying back with memcpy keeps every node and its data in place.
+     */
+    void sortImpl(sort_tag<true>) {
+        T *values = static_cast<T *>(::operator new(sizeof(T) * listSize));
+        size_t idx = 0;
+        for (node *cur = head->next; cur != tail; cur = cur->next) {
+            memcpy(static_cast<void *>(values + idx++), cur->data, sizeof(T));
+        }
+
+#ifdef SJTU_LIST_STATS
+        // counting needs a comparator, so stats builds take the generic merge
+        sjtu::stable_sort(values, values + listSize, [&](const T &a, const T &b) {
+            SJTU_LIST_COUNT(sort_comparisons);
+            return a < b;
+        });
+#else
+        sjtu::stable_sort(values, values + listSize);
+#endif
+
+        idx = 0;
+        for (node *cur = head->next; cur != tail; cur = cur->next) {
+            memcpy(static_cast<void *>(cur->data), values + idx++, sizeof(T));
+        }
+        ::operator delete(values);
+    }
 
+    void sortImpl(sort_tag<false>) {
         // Allocate raw memory for array (no default constructor required)
         T **arr = new T*[listSize];
         size_t idx = 0;
@@ -487,8 +710,11 @@ public:
             arr[idx++] = cur->data;
         }
 
-        // Sort array of pointers
-        sjtu::sort<T*>(arr, arr + listSize, [](T* const &a, T* const &b) { return *a < *b; });
+        // Sort array of pointers; stable, so equal elements keep their order
+        sjtu::stable_sort(arr, arr + listSize, [&](T* const &a, T* const &b) {
+            SJTU_LIST_COUNT(sort_comparisons);
+            return *a < *b;
+        });
 
         // Relink nodes in sorted order
         node *cur = head->next;
@@ -500,6 +726,18 @@ public:
         delete[] arr;
     }
 
+public:
+    /**
+     * sort the values in ascending order with operator< of T
+     */
+    void sort() {
+        SJTU_LIST_COUNT(sort);
+        SJTU_LIST_TIME(sort_latency);
+        SJTU_LIST_TRACE_OP(Sort);
+        if (listSize <= 1) return;
+        sortImpl(sort_tag<__is_trivially_copyable(T) && sizeof(T) <= SORT_BY_VALUE_MAX_SIZE>());
+    }
+
     /**
      * merge two sorted lists into one (both in ascending order)
      * compare with operator< of T
@@ -509,12 +747,16 @@ public:
      * no elements are copied or moved
      */
     void merge(list &other) {
+        SJTU_LIST_COUNT(merge);
+        SJTU_LIST_TIME(merge_latency);
+        SJTU_LIST_TRACE_OP(Merge);
         if (this == &other) return;
 
         node *cur1 = head->next;
         node *cur2 = other.head->next;
 
         while (cur1 != tail && cur2 != other.tail) {
+            SJTU_LIST_COUNT(merge_comparisons);
             if (*(cur2->data) < *(cur1->data)) {
                 node *next2 = cur2->next;
                 // Remove from other
@@ -544,6 +786,9 @@ public:
      * no elements are copied or moved
      */
     void reverse() {
+        SJTU_LIST_COUNT(reverse);
+        SJTU_LIST_TIME(reverse_latency);
+        SJTU_LIST_TRACE_OP(Reverse);
         if (listSize <= 1) return;
 
         node *cur = head->next;
@@ -569,22 +814,131 @@ public:
      * use operator== of T to compare the elements.
      */
     void unique() {
+        SJTU_LIST_COUNT(unique);
+        SJTU_LIST_TIME(unique_latency);
+        SJTU_LIST_TRACE_OP(Unique);
         if (listSize <= 1) return;
 
         node *cur = head->next;
         while (cur != tail && cur->next != tail) {
+            SJTU_LIST_COUNT(unique_comparisons);
             if (*(cur->data) == *(cur->next->data)) {
                 node *duplicate = cur->next;
                 erase(duplicate);
-                delete duplicate;
+                destroy(duplicate);
                 listSize--;
             } else {
                 cur = cur->next;
             }
         }
     }
+
+    /**
+     * counters and latency histograms of this list (SJTU_LIST_STATS builds);
+     * all zero when the option is off.
+     */
+    list_stats stats() const {
+#ifdef SJTU_LIST_STATS
+        return statsData;
+#else
+        return list_stats();
+#endif
+    }
+
+    /**
+     * restart counting from zero
+     */
+    void reset_stats() {
+#ifdef SJTU_LIST_STATS
+        statsData = list_stats();
+#endif
+    }
+
+    /**
+     * memory the list has allocated, with malloc overhead estimated as for
+     * glibc: each block takes its size plus an 8-byte header, rounded up to
+     * 16 bytes, and at least 32 bytes.
+     */
+    list_footprint memory_footprint() const {
+        list_footprint f;
+        f.nodes = listSize;
+        f.node_bytes = listSize * sizeof(node);
+        f.payload_bytes = listSize * sizeof(T);
+        f.sentinel_bytes = 2 * sizeof(node);
+        f.overhead_bytes = (listSize + 2) * (mallocBlock(sizeof(node)) - sizeof(node)) +
+                           listSize * (mallocBlock(sizeof(T)) - sizeof(T));
+        f.total_bytes = f.node_bytes + f.payload_bytes + f.sentinel_bytes + f.overhead_bytes + sizeof(*this);
+        return f;
+    }
+
+    /**
+     * walk the list and measure the address distance between consecutive
+     * nodes. Nodes allocated in order usually sit a fixed stride apart;
+     * a high page-crossing rate after many inserts and erases means
+     * iteration pays a cache miss (and possibly a TLB miss) per element,
+     * which is when rebuilding the list or moving to a contiguous
+     * container pays off. O(n) time, no allocation.
+     */
+    list_locality locality_report() const {
+        const int BUCKETS = 64;
+        const size_t PAGE = 4096;
+        size_t buckets[BUCKETS] = {};
+        list_locality r = list_locality();
+        double total = 0;
+        size_t forward = 0, crossings = 0, split = 0;
+        for (node *cur = head->next; cur != tail; cur = cur->next) {
+            size_t here = reinterpret_cast<size_t>(cur);
+            if (reinterpret_cast<size_t>(cur->data) / PAGE != here / PAGE) ++split;
+            if (cur->next == tail) break;
+            size_t there = reinterpret_cast<size_t>(cur->next);
+            size_t distance = there > here ? there - here : here - there;
+            int b = 0;
+            while (b + 1 < BUCKETS && (size_t(1) << (b + 1)) <= distance) ++b;
+            ++buckets[b];
+            ++r.links;
+            total += distance;
+            if (distance > r.max_distance) r.max_distance = distance;
+            if (there > here) ++forward;
+            if (there / PAGE != here / PAGE) ++crossings;
+        }
+        if (listSize) r.payload_split_rate = static_cast<double>(split) / listSize;
+        if (!r.links) return r;
+        r.mean_distance = total / r.links;
+        r.forward_rate = static_cast<double>(forward) / r.links;
+        r.page_crossing_rate = static_cast<double>(crossings) / r.links;
+        r.p50_distance = bucketQuantile(buckets, BUCKETS, r.links, 0.5, r.max_distance);
+        r.p90_distance = bucketQuantile(buckets, BUCKETS, r.links, 0.9, r.max_distance);
+        r.p99_distance = bucketQuantile(buckets, BUCKETS, r.links, 0.99, r.max_distance);
+        return r;
+    }
+
+private:
+    static size_t mallocBlock(size_t request) {
+        size_t block = (request + 8 + 15) / 16 * 16;
+        return block < 32 ? 32 : block;
+    }
+
+    /**
+     * upper bound of the log2 bucket holding the p-quantile, clamped to max.
+     */
+    static size_t bucketQuantile(const size_t *buckets, int count, size_t total, double p, size_t max) {
+        size_t rank = static_cast<size_t>(p * total + 0.999999), seen = 0;
+        for (int b = 0; b < count; ++b) {
+            seen += buckets[b];
+            if (seen >= rank && seen) {
+                size_t bound = b + 1 < static_cast<int>(sizeof(size_t) * CHAR_BIT) ? (size_t(1) << (b + 1)) - 1 : max;
+                return bound < max ? bound : max;
+            }
+        }
+        return max;
+    }
 };
 
+#undef SJTU_LIST_COUNT
+#undef SJTU_LIST_TIME
+#undef SJTU_LIST_TRACE_OP
+#undef SJTU_LIST_CHECK_ITERATOR
+
 }
 
 #endif //SJTU_LIST_HPP
@@ -0,0 +1,225 @@
+#ifndef SJTU_LIST_TRACE_HPP
+#define SJTU_LIST_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if defined(SJTU_LIST_TRACE_RDTSC) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define SJTU_LIST_TRACE_USE_TSC 1
+#endif
+
+#ifndef SJTU_LIST_TRACE_CAPACITY
+#define SJTU_LIST_TRACE_CAPACITY 16384  // records per thread, a power of two
+#endif
+
+/**
+ * Event tracing for sjtu::list, enabled by compiling with SJTU_LIST_TRACE.
+ *
+ * Every mutation appends one fixed-size record (start, duration, list
+ * address, size afterwards, operation) to a ring buffer owned by the calling
+ * thread, so recording takes no lock and never allocates after the first
+ * event of a thread. Each ring keeps the last SJTU_LIST_TRACE_CAPACITY
+ * records. Timestamps come from steady_clock in nanoseconds, or from rdtsc
+ * when SJTU_LIST_TRACE_RDTSC is also defined on x86.
+ *
+ * dump() writes the records of all threads to a binary file that the
+ * trace2chrome tool turns into Chrome trace JSON. Setting the environment
+ * variable SJTU_LIST_TRACE_FILE dumps there at exit.
+ */
+namespace sjtu {
+
+namespace tracing {
+
+enum op_code : uint32_t {
+    PushBack, PushFront, PopBack, PopFront, Insert, Erase,
+    Sort, Merge, Unique, Reverse, Clear, Copy, OpCount
+};
+
+inline const char *opName(uint32_t op) {
+    static const char *names[OpCount] = {
+        "push_back", "push_front", "pop_back", "pop_front", "insert", "erase",
+        "sort", "merge", "unique", "reverse", "clear", "copy"
+    };
+    return op < OpCount ? names[op] : "?";
+}
+
+struct record {
+    uint64_t start;     // clock ticks
+    uint64_t duration;  // clock ticks
+    uint64_t list;      // address of the list
+    uint64_t size;      // size of the list after the operation
+    uint32_t op;
+    uint32_t thread;
+};
+
+/**
+ * single-writer ring: only the owning thread writes, and it publishes
+ * each record by bumping head after filling it in.
+ */
+struct ring {
+    static const uint64_t CAPACITY = SJTU_LIST_TRACE_CAPACITY;
+    record records[CAPACITY];
+    std::atomic<uint64_t> head;
+    uint32_t thread;
+    ring *next;
+};
+
+static_assert((ring::CAPACITY & (ring::CAPACITY - 1)) == 0, "SJTU_LIST_TRACE_CAPACITY must be a power of two");
+
+inline uint64_t now() {
+#ifdef SJTU_LIST_TRACE_USE_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * the first clock reading, paired with steady_clock, so that tick rates
+ * can be calibrated at dump time.
+ */
+struct epoch {
+    uint64_t ticks;
+    std::chrono::steady_clock::time_point time;
+};
+
+inline const epoch &origin() {
+    static const epoch e = {now(), std::chrono::steady_clock::now()};
+    return e;
+}
+
+inline double ticksPerMicrosecond() {
+#ifdef SJTU_LIST_TRACE_USE_TSC
+    const epoch &e = origin();
+    uint64_t ticks = now();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - e.time).count();
+    return us > 0 ? (ticks - e.ticks) / us : 1000.0;
+#else
+    return 1000.0;
+#endif
+}
+
+/**
+ * head of the lock-free list of all rings ever created; rings live until exit.
+ */
+inline std::atomic<ring *> &rings() {
+    static std::atomic<ring *> first(nullptr);
+    return first;
+}
+
+inline bool dump(const char *path);
+
+inline void dumpAtExit() {
+    const char *path = getenv("SJTU_LIST_TRACE_FILE");
+    if (path != nullptr && !dump(path)) fprintf(stderr, "list trace: cannot write %s\n", path);
+}
+
+inline ring *attach() {
+    static std::atomic<uint32_t> threads(0);
+    static bool hooked = getenv("SJTU_LIST_TRACE_FILE") != nullptr && atexit(dumpAtExit) == 0;
+    (void)hooked;
+    origin();
+    ring *r = new ring();
+    r->head.store(0, std::memory_order_relaxed);
+    r->thread = threads.fetch_add(1, std::memory_order_relaxed);
+    r->next = rings().load(std::memory_order_relaxed);
+    while (!rings().compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {}
+    return r;
+}
+
+inline ring &local() {
+    static thread_local ring *mine = attach();
+    return *mine;
+}
+
+inline void write(uint32_t op, const void *list, uint64_t size, uint64_t start, uint64_t end) {
+    ring &r = local();
+    uint64_t h = r.head.load(std::memory_order_relaxed);
+    record &rec = r.records[h & (ring::CAPACITY - 1)];
+    rec.start = start;
+    rec.duration = end - start;
+    rec.list = reinterpret_cast<uintptr_t>(list);
+    rec.size = size;
+    rec.op = op;
+    rec.thread = r.thread;
+    r.head.store(h + 1, std::memory_order_release);
+}
+
+/**
+ * records one operation over the lifetime of the scope.
+ */
+class scope {
+private:
+    uint32_t op;
+    const void *list;
+    const size_t &size;
+    uint64_t start;
+
+public:
+    scope(uint32_t op, const void *list, const size_t &size) : op(op), list(list), size(size), start(now()) {}
+
+    ~scope() {
+        write(op, list, size, start, now());
+    }
+
+    scope(const scope &) = delete;
+    scope &operator=(const scope &) = delete;
+};
+
+/**
+ * the records currently held by all rings, ordered by start time.
+ * May be called while other threads keep tracing: the record fields are
+ * plain memory, so the copy races with the writers (ThreadSanitizer will
+ * say so), but every record a writer could have overwritten during the
+ * copy is dropped afterwards.
+ */
+inline std::vector<record> snapshot() {
+    std::vector<record> out;
+    for (ring *r = rings().load(std::memory_order_acquire); r != nullptr; r = r->next) {
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t first = head > ring::CAPACITY ? head - ring::CAPACITY : 0;
+        size_t base = out.size();
+        for (uint64_t i = first; i < head; ++i) out.push_back(r->records[i & (ring::CAPACITY - 1)]);
+        uint64_t after = r->head.load(std::memory_order_acquire);
+        uint64_t safe = after > ring::CAPACITY ? after - ring::CAPACITY : 0;
+        if (safe > first) {
+            size_t torn = static_cast<size_t>(std::min(safe - first, head - first));
+            out.erase(out.begin() + base, out.begin() + base + torn);
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const record &a, const record &b) { return a.start < b.start; });
+    return out;
+}
+
+const char MAGIC[4] = {'L', 'T', 'R', 'B'};
+const uint32_t VERSION = 1;
+
+/**
+ * write snapshot() to path: the magic "LTRB", a uint32 version, a double
+ * giving clock ticks per microsecond, a uint64 record count, then the
+ * records as stored in memory.
+ */
+inline bool dump(const char *path) {
+    std::vector<record> records = snapshot();
+    double rate = ticksPerMicrosecond();
+    uint64_t count = records.size();
+    FILE *f = fopen(path, "wb");
+    if (f == nullptr) return false;
+    bool ok = fwrite(MAGIC, 1, 4, f) == 4 && fwrite(&VERSION, sizeof(VERSION), 1, f) == 1 &&
+              fwrite(&rate, sizeof(rate), 1, f) == 1 && fwrite(&count, sizeof(count), 1, f) == 1 &&
+              (count == 0 || fwrite(records.data(), sizeof(record), records.size(), f) == records.size());
+    return fclose(f) == 0 && ok;
+}
+
+}
+
+}
+
+#endif //SJTU_LIST_TRACE_HPP
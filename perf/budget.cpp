@@ -0,0 +1,285 @@
+/**
+ * perf_budget: run a workload and fail when it regresses past its budget.
+ *
+ *   perf_budget --name NAME --baseline FILE [--time-margin F] [--rss-margin F]
+ *               [--max-wall-ms MS] [--max-rss-mib MIB] [--expect FILE] [--update]
+ *               -- COMMAND [ARGS...]
+ *
+ * The child's wall time and peak RSS (ru_maxrss from wait4) are compared with
+ * the NAME entry of the baseline file; the test fails when either exceeds
+ * baseline * (1 + margin) or the absolute limits. With --expect the child's
+ * stdout must also match FILE. --update rewrites the NAME entry with the
+ * measured numbers instead of checking them.
+ *
+ * Wall times are not compared as raw milliseconds: before the child runs,
+ * a fixed calibration loop (allocation churn and a dependent pointer chase)
+ * is timed, and the wall budget is scaled by how much slower or faster it
+ * ran than when the entry was recorded. --update records it with the entry.
+ *
+ * The baseline file holds one "name wall_ms rss_kib calibration_ms" line per
+ * workload; lines starting with '#' are comments.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct Measurement {
+    double wallMs;
+    long rssKib;
+    int status;
+    std::string output;
+};
+
+struct BaselineEntry {
+    std::string name;
+    double wallMs;
+    long rssKib;
+    double calibrationMs;
+};
+
+bool readFile(const std::string &path, std::string &content) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) return false;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    content = ss.str();
+    return true;
+}
+
+std::vector<std::string> readLines(const std::string &path) {
+    std::vector<std::string> lines;
+    std::ifstream in(path.c_str());
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+bool findEntry(const std::vector<std::string> &lines, const std::string &name, BaselineEntry &entry) {
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (lines[i].empty() || lines[i][0] == '#') continue;
+        std::istringstream ss(lines[i]);
+        BaselineEntry e;
+        if (ss >> e.name >> e.wallMs >> e.rssKib >> e.calibrationMs && e.name == name) {
+            entry = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool updateEntry(const std::string &path, const std::string &name, const Measurement &m, double calibrationMs) {
+    std::vector<std::string> lines = readLines(path);
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s %.0f %ld %.1f", name.c_str(), m.wallMs, m.rssKib, calibrationMs);
+    bool replaced = false;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        std::istringstream ss(lines[i]);
+        std::string first;
+        if (!lines[i].empty() && lines[i][0] != '#' && ss >> first && first == name) {
+            lines[i] = buf;
+            replaced = true;
+        }
+    }
+    if (!replaced) lines.push_back(buf);
+    std::ofstream out(path.c_str());
+    if (!out) return false;
+    for (size_t i = 0; i < lines.size(); ++i) out << lines[i] << '\n';
+    return true;
+}
+
+/**
+ * Time a fixed mix of small allocations and a dependent pointer chase over
+ * 16 MiB, roughly what the list workloads spend their time on, and return
+ * the fastest of a few runs in milliseconds.
+ */
+double calibrate() {
+    const size_t slots = size_t(1) << 22;
+    std::vector<unsigned> next(slots);
+    unsigned seed = 12345;
+    for (size_t i = 0; i < slots; ++i) next[i] = static_cast<unsigned>(i);
+    for (size_t i = slots - 1; i > 0; --i) {
+        seed = seed * 1103515245u + 12345u;
+        std::swap(next[i], next[seed % i]);
+    }
+    double best = 0;
+    volatile unsigned sink = 0;
+    for (int run = 0; run < 5; ++run) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        std::vector<int *> nodes(1 << 16);
+        for (int round = 0; round < 8; ++round) {
+            for (size_t i = 0; i < nodes.size(); ++i) nodes[i] = new int(static_cast<int>(i));
+            for (size_t i = 0; i < nodes.size(); ++i) delete nodes[i];
+        }
+        unsigned at = 0;
+        for (size_t i = 0; i < (size_t(1) << 19); ++i) at = next[at];
+        sink = sink + at;
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        if (run == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+/**
+ * fork/exec argv, capture its stdout and collect wall time and peak RSS.
+ */
+bool runChild(char **argv, Measurement &m) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return false;
+    }
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execvp(argv[0], argv);
+        perror("execvp");
+        _exit(127);
+    }
+    close(fds[1]);
+    char buf[4096];
+    ssize_t got;
+    while ((got = read(fds[0], buf, sizeof(buf))) > 0) {
+        m.output.append(buf, static_cast<size_t>(got));
+    }
+    close(fds[0]);
+    struct rusage usage;
+    if (wait4(pid, &m.status, 0, &usage) < 0) {
+        perror("wait4");
+        return false;
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    m.wallMs = std::chrono::duration<double, std::milli>(end - begin).count();
+    m.rssKib = usage.ru_maxrss;  // KiB on Linux
+    return true;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s --name NAME --baseline FILE [--time-margin F] [--rss-margin F]\n"
+            "          [--max-wall-ms MS] [--max-rss-mib MIB] [--expect FILE] [--update] -- COMMAND...\n",
+            prog);
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string name, baseline, expect;
+    double timeMargin = 0.5, rssMargin = 0.2;
+    double maxWallMs = 0, maxRssMib = 0;
+    bool update = false;
+    int cmd = -1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--") {
+            cmd = i + 1;
+            break;
+        } else if (arg == "--name" && hasValue) {
+            name = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baseline = argv[++i];
+        } else if (arg == "--time-margin" && hasValue) {
+            timeMargin = atof(argv[++i]);
+        } else if (arg == "--rss-margin" && hasValue) {
+            rssMargin = atof(argv[++i]);
+        } else if (arg == "--max-wall-ms" && hasValue) {
+            maxWallMs = atof(argv[++i]);
+        } else if (arg == "--max-rss-mib" && hasValue) {
+            maxRssMib = atof(argv[++i]);
+        } else if (arg == "--expect" && hasValue) {
+            expect = argv[++i];
+        } else if (arg == "--update") {
+            update = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (name.empty() || baseline.empty() || cmd < 0 || cmd >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    double calibrationMs = calibrate();
+    Measurement m;
+    if (!runChild(argv + cmd, m)) return 1;
+    printf("%s: wall %.0f ms, peak RSS %ld KiB, calibration %.1f ms\n", name.c_str(), m.wallMs, m.rssKib,
+           calibrationMs);
+
+    bool okay = true;
+    if (!WIFEXITED(m.status) || WEXITSTATUS(m.status) != 0) {
+        printf("%s: workload did not exit cleanly (status %d)\n", name.c_str(), m.status);
+        okay = false;
+    }
+    if (!expect.empty()) {
+        std::string answer;
+        if (!readFile(expect, answer)) {
+            printf("%s: cannot read %s\n", name.c_str(), expect.c_str());
+            okay = false;
+        } else if (answer != m.output) {
+            printf("%s: output differs from %s\n", name.c_str(), expect.c_str());
+            okay = false;
+        }
+    }
+    if (!okay) return 1;
+
+    if (update) {
+        if (!updateEntry(baseline, name, m, calibrationMs)) {
+            printf("%s: cannot write %s\n", name.c_str(), baseline.c_str());
+            return 1;
+        }
+        printf("%s: baseline updated\n", name.c_str());
+        return 0;
+    }
+
+    if (maxWallMs > 0 && m.wallMs > maxWallMs) {
+        printf("%s: wall time exceeds the hard limit of %.0f ms\n", name.c_str(), maxWallMs);
+        okay = false;
+    }
+    if (maxRssMib > 0 && m.rssKib > maxRssMib * 1024) {
+        printf("%s: peak RSS exceeds the hard limit of %.0f MiB\n", name.c_str(), maxRssMib);
+        okay = false;
+    }
+
+    BaselineEntry entry;
+    if (!findEntry(readLines(baseline), name, entry) || entry.calibrationMs <= 0) {
+        printf("%s: no baseline entry in %s, only the hard limits were checked\n", name.c_str(), baseline.c_str());
+        return okay ? 0 : 1;
+    }
+    double speed = calibrationMs / entry.calibrationMs;
+    double expectedMs = entry.wallMs * speed;
+    double wallBudget = expectedMs * (1 + timeMargin);
+    double rssBudget = entry.rssKib * (1 + rssMargin);
+    printf("%s: budget %.0f ms (baseline %.0f scaled by %.2f, +%.0f%%), %.0f KiB (baseline %ld, +%.0f%%)\n",
+           name.c_str(), wallBudget, entry.wallMs, speed, timeMargin * 100, rssBudget, entry.rssKib, rssMargin * 100);
+    if (m.wallMs > wallBudget) {
+        printf("%s: wall time regressed by %.1f%%\n", name.c_str(), (m.wallMs / expectedMs - 1) * 100);
+        okay = false;
+    }
+    if (m.rssKib > rssBudget) {
+        printf("%s: peak RSS regressed by %.1f%%\n", name.c_str(), (static_cast<double>(m.rssKib) / entry.rssKib - 1) * 100);
+        okay = false;
+    }
+    return okay ? 0 : 1;
+}
@@ -0,0 +1,480 @@
+#ifndef SJTU_SIMD_SORT_HPP
+#define SJTU_SIMD_SORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__) && \
+    !defined(SJTU_NO_SIMD_SORT)
+#include <immintrin.h>
+#define SJTU_SIMD_SORT_X86 1
+#endif
+
+/**
+ * Vectorized sorting of int32 / int64 / float / double arrays by operator<.
+ *
+ * The kernel (simd_sort_kernel.hpp) is a quicksort whose partition packs
+ * each vector with a shuffle table, on top of a bitonic sorting network
+ * for small ranges. It is compiled twice, for AVX2 and for SSE4.2, and
+ * picked at run time from the CPU; other platforms and compilers, and
+ * builds with SJTU_NO_SIMD_SORT, get no kernel and sort() returns false.
+ *
+ * The result must be the one any correct comparison sort gives, so only
+ * inputs where equal elements are bit-identical are accepted: integers
+ * always, floating point unless it holds a NaN or a -0.0.
+ */
+namespace sjtu {
+
+namespace simd {
+
+enum level {
+    Scalar, SSE42, AVX2
+};
+
+inline const char *levelName(level l) {
+    return l == AVX2 ? "avx2" : l == SSE42 ? "sse4.2" : "scalar";
+}
+
+/**
+ * the best level this CPU runs.
+ */
+inline level detected() {
+#ifdef SJTU_SIMD_SORT_X86
+    static const level best = __builtin_cpu_supports("avx2") ? AVX2 :
+                              __builtin_cpu_supports("sse4.2") ? SSE42 : Scalar;
+    return best;
+#else
+    return Scalar;
+#endif
+}
+
+/**
+ * vectors per bitonic block; longer ranges are partitioned.
+ */
+const size_t SMALL_SORT_VECTORS = 8;
+
+template<class T>
+inline T median3(T x, T y, T z) {
+    return x < y ? (y < z ? y : (x < z ? z : x)) : (x < z ? x : (y < z ? z : y));
+}
+
+/**
+ * depth-limit fallback of the quicksort.
+ */
+template<class T>
+void heapSort(T *a, size_t n) {
+    for (size_t end = n, start = n / 2; end > 1;) {
+        if (start > 0) {
+            --start;
+        } else {
+            --end;
+            T top = a[0];
+            a[0] = a[end];
+            a[end] = top;
+        }
+        size_t root = start;
+        T x = a[root];
+        for (size_t child; (child = 2 * root + 1) < end; root = child) {
+            if (child + 1 < end && a[child] < a[child + 1]) ++child;
+            if (!(x < a[child])) break;
+            a[root] = a[child];
+        }
+        a[root] = x;
+    }
+}
+
+/**
+ * shuffle indices that pack the lanes selected by a mask to the front, in
+ * order, followed by the other lanes: for each of the 2^LANES masks, one
+ * index per UNITS-sized piece of a lane (bytes for pshufb, 32-bit words
+ * for vpermd).
+ */
+template<int LANES, int UNITS>
+struct compress_table {
+    alignas(16) unsigned char index[1 << LANES][16];
+
+    compress_table() {
+        memset(index, 0, sizeof(index));
+        for (int mask = 0; mask < (1 << LANES); ++mask) {
+            int out = 0;
+            for (int pass = 0; pass < 2; ++pass) {
+                for (int lane = 0; lane < LANES; ++lane) {
+                    if (((mask >> lane) & 1) != (pass == 0)) continue;
+                    for (int u = 0; u < UNITS; ++u) index[mask][out++] = static_cast<unsigned char>(lane * UNITS + u);
+                }
+            }
+        }
+    }
+};
+
+template<int LANES, int UNITS>
+const unsigned char (*compressTable())[16] {
+    static const compress_table<LANES, UNITS> table;
+    return table.index;
+}
+
+#ifdef SJTU_SIMD_SORT_X86
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+namespace avx2 {
+
+inline __m256i permutation(const unsigned char *index) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(index)));
+}
+
+inline __m256i laneMask32(int bits) {
+    const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), select), select);
+}
+
+inline __m256i laneMask64(int bits) {
+    const __m256i select = _mm256_setr_epi64x(1, 2, 4, 8);
+    return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), select), select);
+}
+
+template<class T>
+struct I32 {
+    typedef T lane;
+    typedef __m256i vec;
+    static const int LANES = 8;
+
+    static vec load(const T *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    static void store(T *p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    static vec set1(T x) { return _mm256_set1_epi32(x); }
+    static vec min(vec a, vec b) { return _mm256_min_epi32(a, b); }
+    static vec max(vec a, vec b) { return _mm256_max_epi32(a, b); }
+    static int less(vec a, vec p) { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(p, a))); }
+    static int greater(vec a, vec p) { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, p))); }
+    static vec compress(vec v, int mask, const unsigned char (*table)[16]) {
+        return _mm256_permutevar8x32_epi32(v, permutation(table[mask]));
+    }
+    static vec swap(vec v, int j) {
+        return j == 1 ? _mm256_shuffle_epi32(v, 0xB1) : j == 2 ? _mm256_shuffle_epi32(v, 0x4E) :
+                        _mm256_permute2x128_si256(v, v, 1);
+    }
+    static vec blend(vec a, vec b, int bits) { return _mm256_blendv_epi8(a, b, laneMask32(bits)); }
+    static T pad() { return std::numeric_limits<T>::max(); }
+    static const unsigned char (*table())[16] { return compressTable<8, 1>(); }
+};
+
+template<class T>
+struct I64 {
+    typedef T lane;
+    typedef __m256i vec;
+    static const int LANES = 4;
+
+    static vec load(const T *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    static void store(T *p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    static vec set1(T x) { return _mm256_set1_epi64x(x); }
+    static vec min(vec a, vec b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+    static vec max(vec a, vec b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+    static int less(vec a, vec p) { return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(p, a))); }
+    static int greater(vec a, vec p) { return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, p))); }
+    static vec compress(vec v, int mask, const unsigned char (*table)[16]) {
+        return _mm256_permutevar8x32_epi32(v, permutation(table[mask]));
+    }
+    static vec swap(vec v, int j) {
+        return j == 1 ? _mm256_shuffle_epi32(v, 0x4E) : _mm256_permute2x128_si256(v, v, 1);
+    }
+    static vec blend(vec a, vec b, int bits) { return _mm256_blendv_epi8(a, b, laneMask64(bits)); }
+    static T pad() { return std::numeric_limits<T>::max(); }
+    static const unsigned char (*table())[16] { return compressTable<4, 2>(); }
+};
+
+struct F32 {
+    typedef float lane;
+    typedef __m256 vec;
+    static const int LANES = 8;
+
+    static vec load(const float *p) { return _mm256_loadu_ps(p); }
+    static void store(float *p, vec v) { _mm256_storeu_ps(p, v); }
+    static vec set1(float x) { return _mm256_set1_ps(x); }
+    static vec min(vec a, vec b) { return _mm256_min_ps(a, b); }
+    static vec max(vec a, vec b) { return _mm256_max_ps(a, b); }
+    static int less(vec a, vec p) { return _mm256_movemask_ps(_mm256_cmp_ps(a, p, _CMP_LT_OQ)); }
+    static int greater(vec a, vec p) { return _mm256_movemask_ps(_mm256_cmp_ps(a, p, _CMP_GT_OQ)); }
+    static vec compress(vec v, int mask, const unsigned char (*table)[16]) {
+        return _mm256_permutevar8x32_ps(v, permutation(table[mask]));
+    }
+    static vec swap(vec v, int j) {
+        return j == 1 ? _mm256_permute_ps(v, 0xB1) : j == 2 ? _mm256_permute_ps(v, 0x4E) :
+                        _mm256_permute2f128_ps(v, v, 1);
+    }
+    static vec blend(vec a, vec b, int bits) { return _mm256_blendv_ps(a, b, _mm256_castsi256_ps(laneMask32(bits))); }
+    static float pad() { return std::numeric_limits<float>::infinity(); }
+    static const unsigned char (*table())[16] { return compressTable<8, 1>(); }
+};
+
+struct F64 {
+    typedef double lane;
+    typedef __m256d vec;
+    static const int LANES = 4;
+
+    static vec load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, vec v) { _mm256_storeu_pd(p, v); }
+    static vec set1(double x) { return _mm256_set1_pd(x); }
+    static vec min(vec a, vec b) { return _mm256_min_pd(a, b); }
+    static vec max(vec a, vec b) { return _mm256_max_pd(a, b); }
+    static int less(vec a, vec p) { return _mm256_movemask_pd(_mm256_cmp_pd(a, p, _CMP_LT_OQ)); }
+    static int greater(vec a, vec p) { return _mm256_movemask_pd(_mm256_cmp_pd(a, p, _CMP_GT_OQ)); }
+    static vec compress(vec v, int mask, const unsigned char (*table)[16]) {
+        return _mm256_castsi256_pd(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(v), permutation(table[mask])));
+    }
+    static vec swap(vec v, int j) {
+        return j == 1 ? _mm256_permute_pd(v, 0x5) : _mm256_permute2f128_pd(v, v, 1);
+    }
+    static vec blend(vec a, vec b, int bits) { return _mm256_blendv_pd(a, b, _mm256_castsi256_pd(laneMask64(bits))); }
+    static double pad() { return std::numeric_limits<double>::infinity(); }
+    static const unsigned char (*table())[16] { return compressTable<4, 2>(); }
+};
+
+#include "simd_sort_kernel.hpp"
+
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+
+namespace sse42 {
+
+inline __m128i shuffle(const unsigned char *index) {
+    return _mm_load_si128(reinterpret_cast<const __m128i *>(index));
+}
+
+inline __m128i laneMask32(int bits) {
+    const __m128i select = _mm_setr_epi32(1, 2, 4, 8);
+    return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), select), select);
+}
+
+inline __m128i laneMask64(int bits) {
+    const __m128i select = _mm_set_epi64x(2, 1);
+    return _mm_cmpeq_epi64(_mm_and_si128(_mm_set1_epi64x(bits), select), select);
+}
+
+template<class T>
+struct I32 {
+    typedef T lane;
+    typedef __m128i vec;
+    static const int LANES = 4;
+
+    static vec load(const T *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+    static void store(T *p, vec v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+    static vec set1(T x) { return _mm_set1_epi32(x); }
+    static vec min(vec a, vec b) { return _mm_min_epi32(a, b); }
+    static vec max(vec a, vec b) { return _mm_max_epi32(a, b); }
+    static int less(vec a, vec p) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(p, a))); }
+    static int greater(vec a, vec p) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(a, p))); }
+    static vec compress(vec v, int mask, const unsigned char (*table)[16]) {
+        return _mm_shuffle_epi8(v, shuffle(table[mask]));
+    }
+    static vec swap(vec v, int j) { return j == 1 ? _mm_shuffle_epi32(v, 0xB1) : _mm_shuffle_epi32(v, 0x4E); }
+    static vec blend(vec a, vec b, int bits) { return _mm_blendv_epi8(a, b, laneMask32(bits)); }
+    static T pad() { return std::numeric_limits<T>::max(); }
+    static const unsigned char (*table())[16] { return compressTable<4, 4>(); }
+};
+
+template<class T>
+struct I64 {
+    typedef T lane;
+    typedef __m128i vec;
+    static const int LANES = 2;
+
+    static vec load(const T *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+    static void store(T *p, vec v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+    static vec set1(T x) { return _mm_set1_epi64x(x); }
+    static vec min(vec a, vec b) { return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(a, b)); }
+    static vec max(vec a, vec b) { return _mm_blendv_epi8(b, a, _mm_cmpgt_epi64(a, b)); }
+    static int less(vec a, vec p) { return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(p, a))); }
+    static int greater(vec a, vec p) { return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(a, p))); }
+    static vec compress(vec v, int mask, const unsigned char (*table)[16]) {
+        return _mm_shuffle_epi8(v, shuffle(table[mask]));
+    }
+    static vec swap(vec v, int) { return _mm_shuffle_epi32(v, 0x4E); }
+    static vec blend(vec a, vec b, int bits) { return _mm_blendv_epi8(a, b, laneMask64(bits)); }
+    static T pad() { return std::numeric_limits<T>::max(); }
+    static const unsigned char (*table())[16] { return compressTable<2, 8>(); }
+};
+
+struct F32 {
+    typedef float lane;
+    typedef __m128 vec;
+    static const int LANES = 4;
+
+    static vec load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, vec v) { _mm_storeu_ps(p, v); }
+    static vec set1(float x) { return _mm_set1_ps(x); }
+    static vec min(vec a, vec b) { return _mm_min_ps(a, b); }
+    static vec max(vec a, vec b) { return _mm_max_ps(a, b); }
+    static int less(vec a, vec p) { return _mm_movemask_ps(_mm_cmplt_ps(a, p)); }
+    static int greater(vec a, vec p) { return _mm_movemask_ps(_mm_cmpgt_ps(a, p)); }
+    static vec compress(vec v, int mask, const unsigned char (*table)[16]) {
+        return _mm_castsi128_ps(_mm_shuffle_epi8(_mm_castps_si128(v), shuffle(table[mask])));
+    }
+    static vec swap(vec v, int j) { return j == 1 ? _mm_shuffle_ps(v, v, 0xB1) : _mm_shuffle_ps(v, v, 0x4E); }
+    static vec blend(vec a, vec b, int bits) { return _mm_blendv_ps(a, b, _mm_castsi128_ps(laneMask32(bits))); }
+    static float pad() { return std::numeric_limits<float>::infinity(); }
+    static const unsigned char (*table())[16] { return compressTable<4, 4>(); }
+};
+
+struct F64 {
+    typedef double lane;
+    typedef __m128d vec;
+    static const int LANES = 2;
+
+    static vec load(const double *p) { return _mm_loadu_pd(p); }
+    static void store(double *p, vec v) { _mm_storeu_pd(p, v); }
+    static vec set1(double x) { return _mm_set1_pd(x); }
+    static vec min(vec a, vec b) { return _mm_min_pd(a, b); }
+    static vec max(vec a, vec b) { return _mm_max_pd(a, b); }
+    static int less(vec a, vec p) { return _mm_movemask_pd(_mm_cmplt_pd(a, p)); }
+    static int greater(vec a, vec p) { return _mm_movemask_pd(_mm_cmpgt_pd(a, p)); }
+    static vec compress(vec v, int mask, const unsigned char (*table)[16]) {
+        return _mm_castsi128_pd(_mm_shuffle_epi8(_mm_castpd_si128(v), shuffle(table[mask])));
+    }
+    static vec swap(vec v, int) { return _mm_shuffle_pd(v, v, 1); }
+    static vec blend(vec a, vec b, int bits) { return _mm_blendv_pd(a, b, _mm_castsi128_pd(laneMask64(bits))); }
+    static double pad() { return std::numeric_limits<double>::infinity(); }
+    static const unsigned char (*table())[16] { return compressTable<2, 8>(); }
+};
+
+#include "simd_sort_kernel.hpp"
+
+}
+
+#pragma GCC pop_options
+
+#endif
+
+/**
+ * which traits sort T: Kind 1 for signed 32-bit, 2 for signed 64-bit
+ * integers, 3 for float, 4 for double, 0 when there is no kernel.
+ */
+template<class T>
+struct kind {
+    static const int value = std::numeric_limits<T>::is_integer && std::numeric_limits<T>::is_signed ?
+                             (sizeof(T) == 4 ? 1 : sizeof(T) == 8 ? 2 : 0) : 0;
+};
+
+template<>
+struct kind<float> {
+    static const int value = 3;
+};
+
+template<>
+struct kind<double> {
+    static const int value = 4;
+};
+
+/**
+ * whether the sorted order of [begin, end) is unique bit for bit, so any
+ * kernel gives the scalar result: always for integers, for floating point
+ * when there is no NaN and no -0.0.
+ */
+template<class T>
+bool uniqueOrder(const T *, const T *) {
+    return true;
+}
+
+template<class F>
+bool floatingOrderUnique(const F *begin, const F *end) {
+    bool ok = true;
+    for (const F *p = begin; p != end; ++p) {
+        ok &= *p == *p && !(*p == 0 && 1 / *p < 0);
+    }
+    return ok;
+}
+
+inline bool uniqueOrder(const float *begin, const float *end) {
+    return floatingOrderUnique(begin, end);
+}
+
+inline bool uniqueOrder(const double *begin, const double *end) {
+    return floatingOrderUnique(begin, end);
+}
+
+#ifdef SJTU_SIMD_SORT_X86
+
+template<class T, int Kind = kind<T>::value>
+struct kernels {
+    static void run(level, T *, size_t, T *) {}
+};
+
+template<class T>
+struct kernels<T, 1> {
+    static void run(level l, T *a, size_t n, T *scratch) {
+        if (l == AVX2) avx2::sortRange<avx2::I32<T>>(a, n, scratch);
+        else sse42::sortRange<sse42::I32<T>>(a, n, scratch);
+    }
+};
+
+template<class T>
+struct kernels<T, 2> {
+    static void run(level l, T *a, size_t n, T *scratch) {
+        if (l == AVX2) avx2::sortRange<avx2::I64<T>>(a, n, scratch);
+        else sse42::sortRange<sse42::I64<T>>(a, n, scratch);
+    }
+};
+
+template<>
+struct kernels<float, 3> {
+    static void run(level l, float *a, size_t n, float *scratch) {
+        if (l == AVX2) avx2::sortRange<avx2::F32>(a, n, scratch);
+        else sse42::sortRange<sse42::F32>(a, n, scratch);
+    }
+};
+
+template<>
+struct kernels<double, 4> {
+    static void run(level l, double *a, size_t n, double *scratch) {
+        if (l == AVX2) avx2::sortRange<avx2::F64>(a, n, scratch);
+        else sse42::sortRange<sse42::F64>(a, n, scratch);
+    }
+};
+
+#endif
+
+/**
+ * sort [begin, end) ascending with the kernel for level l. Returns false,
+ * leaving the range untouched, when T has no kernel, the CPU lacks l, the
+ * order is not unique (see uniqueOrder) or the scratch buffer cannot be
+ * allocated; the caller then sorts by other means.
+ */
+template<class T>
+bool sort(T *begin, T *end, level l) {
+#ifdef SJTU_SIMD_SORT_X86
+    if (kind<T>::value == 0 || l == Scalar || l > detected()) return false;
+    size_t n = end - begin;
+    if (n < 2) return true;
+    if (!uniqueOrder(begin, end)) return false;
+    T *scratch = static_cast<T *>(::operator new(sizeof(T) * (n + 8), std::nothrow));
+    if (scratch == nullptr) return false;
+    kernels<T>::run(l, begin, n, scratch);
+    ::operator delete(scratch);
+    return true;
+#else
+    (void)begin;
+    (void)end;
+    (void)l;
+    return false;
+#endif
+}
+
+template<class T>
+bool sort(T *begin, T *end) {
+    return sort(begin, end, detected());
+}
+
+}
+
+}
+
+#undef SJTU_SIMD_SORT_X86
+
+#endif //SJTU_SIMD_SORT_HPP
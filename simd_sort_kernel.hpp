@@ -0,0 +1,138 @@
+/**
+ * Vectorized quicksort kernel, deliberately without an include guard:
+ * simd_sort.hpp includes this file once per instruction set, inside a
+ * namespace and a "#pragma GCC target" region that already define the
+ * lane traits I32, I64, F32 and F64. Every template here is therefore
+ * compiled for that instruction set.
+ *
+ * A traits class V provides, for LANES lanes of type V::lane:
+ *   load / store (unaligned), set1, min, max,
+ *   less(v, p) / greater(v, p): bitmask of the lanes below / above p,
+ *   compress(v, mask, table): the lanes in mask first, the others after,
+ *   swap(v, j): every lane exchanged with lane ^ j (j < LANES),
+ *   blend(a, b, bits): b in the lanes of bits, a elsewhere,
+ *   pad(): a value no element is greater than,
+ *   table(): the compress shuffle table.
+ */
+
+/**
+ * partition a[0, n) around pivot: the lanes below it (or not above it,
+ * when takeEqual) are packed in place to the front, the rest go to scratch
+ * and are copied back behind them. Returns the size of the front part.
+ * In-place stores never pass the vector just loaded; scratch needs
+ * n + LANES elements.
+ */
+template<class V>
+size_t partition(typename V::lane *a, size_t n, typename V::lane pivot, typename V::lane *scratch, bool takeEqual) {
+    typedef typename V::lane T;
+    const int ALL = (1 << V::LANES) - 1;
+    const unsigned char (*table)[16] = V::table();
+    const typename V::vec p = V::set1(pivot);
+    size_t left = 0, right = 0, i = 0;
+    for (; i + V::LANES <= n; i += V::LANES) {
+        typename V::vec v = V::load(a + i);
+        int mask = takeEqual ? ALL & ~V::greater(v, p) : V::less(v, p);
+        int count = __builtin_popcount(mask);
+        V::store(a + left, V::compress(v, mask, table));
+        V::store(scratch + right, V::compress(v, ALL & ~mask, table));
+        left += count;
+        right += V::LANES - count;
+    }
+    for (; i < n; ++i) {
+        T x = a[i];
+        if (takeEqual ? !(pivot < x) : x < pivot) {
+            a[left++] = x;
+        } else {
+            scratch[right++] = x;
+        }
+    }
+    memcpy(a + left, scratch, right * sizeof(T));
+    return left;
+}
+
+/**
+ * bitonic sort of n <= SMALL_SORT_VECTORS * LANES elements, padded to a
+ * power of two (at least one vector). Compare distances of a vector or more
+ * pair whole vectors; shorter ones exchange lanes within a vector and
+ * blend the minima and maxima back into place.
+ */
+template<class V>
+void bitonicSort(typename V::lane *a, size_t n) {
+    typedef typename V::lane T;
+    const size_t L = V::LANES;
+    const int ALL = (1 << V::LANES) - 1;
+    if (n < 2) return;
+    T buf[SMALL_SORT_VECTORS * V::LANES];
+    size_t size = L;
+    while (size < n) size *= 2;
+    memcpy(buf, a, n * sizeof(T));
+    for (size_t i = n; i < size; ++i) buf[i] = V::pad();
+
+    for (size_t k = 2; k <= size; k *= 2) {
+        for (size_t j = k / 2; j > 0; j /= 2) {
+            if (j >= L) {
+                for (size_t i = 0; i < size; i += L) {
+                    if (i & j) continue;
+                    typename V::vec x = V::load(buf + i), y = V::load(buf + i + j);
+                    typename V::vec low = V::min(x, y), high = V::max(x, y);
+                    bool ascending = (i & k) == 0;
+                    V::store(buf + i, ascending ? low : high);
+                    V::store(buf + i + j, ascending ? high : low);
+                }
+            } else {
+                // lane g keeps the maximum iff exactly one of g & j, g & k is set
+                int bits = 0;
+                for (size_t t = 0; t < L; ++t) {
+                    if (((t & j) != 0) != ((t & k) != 0)) bits |= 1 << t;
+                }
+                for (size_t i = 0; i < size; i += L) {
+                    typename V::vec v = V::load(buf + i), w = V::swap(v, static_cast<int>(j));
+                    int keepMax = k >= L && (i & k) ? bits ^ ALL : bits;
+                    V::store(buf + i, V::blend(V::min(v, w), V::max(v, w), keepMax));
+                }
+            }
+        }
+    }
+    memcpy(a, buf, n * sizeof(T));
+}
+
+/**
+ * introsort: ninther pivots (the median of three medians of 3) and vector
+ * partitions down to the bitonic kernel, recursing into the smaller side. When the pivot is the minimum
+ * the elements equal to it are split off instead, so runs of duplicates
+ * cost one extra pass. Past depthLimit the range goes to heapSort.
+ */
+template<class V>
+void quickSort(typename V::lane *a, size_t n, typename V::lane *scratch, int depthLimit) {
+    typedef typename V::lane T;
+    while (n > SMALL_SORT_VECTORS * V::LANES) {
+        if (depthLimit-- == 0) {
+            heapSort(a, n);
+            return;
+        }
+        size_t e = n / 8;
+        T pivot = median3(median3(a[0], a[e], a[2 * e]), median3(a[3 * e], a[4 * e], a[5 * e]),
+                          median3(a[6 * e], a[7 * e], a[n - 1]));
+        size_t left = partition<V>(a, n, pivot, scratch, false);
+        if (left == 0) {
+            left = partition<V>(a, n, pivot, scratch, true);
+            a += left;
+            n -= left;
+        } else if (left < n - left) {
+            quickSort<V>(a, left, scratch, depthLimit);
+            a += left;
+            n -= left;
+        } else {
+            quickSort<V>(a + left, n - left, scratch, depthLimit);
+            n = left;
+        }
+    }
+    bitonicSort<V>(a, n);
+}
+
+template<class V>
+void sortRange(typename V::lane *a, size_t n, typename V::lane *scratch) {
+    int depthLimit = 0;
+    for (size_t m = n; m > 1; m /= 2) depthLimit += 2;
+    quickSort<V>(a, n, scratch, depthLimit);
+}